@@ -0,0 +1,381 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace px
+{
+	//Typed index into an AssetRegistry, the generation tells a recycled slot apart from the asset it used to hold
+	template <typename Asset>
+	struct AssetHandle
+	{
+		static const std::uint32_t INVALID_INDEX = 0xffffffffu;
+
+		AssetHandle() : index(INVALID_INDEX), generation(0) {}
+		AssetHandle(std::uint32_t index, std::uint32_t generation) : index(index), generation(generation) {}
+
+		bool IsValid() const { return index != INVALID_INDEX; }
+		bool operator==(const AssetHandle & other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const AssetHandle & other) const { return !(*this == other); }
+
+		std::uint32_t index;
+		std::uint32_t generation;
+	};
+
+	namespace AssetStates
+	{
+		enum ID
+		{
+			Loading,
+			Loaded,
+			Failed
+		};
+	}
+
+	//Path keyed, reference counted storage. Loading itself is left to the owner, the registry only
+	//deduplicates requests, keeps the byte counts and picks what to evict once over budget
+	template <typename Asset>
+	class AssetRegistry
+	{
+	public:
+		typedef AssetHandle<Asset> Handle;
+
+		struct Entry
+		{
+			std::string path;
+			std::uint64_t hash;
+			std::unique_ptr<Asset> asset;
+			AssetStates::ID state;
+			unsigned int references;
+			std::size_t cpuBytes;
+			std::size_t gpuBytes;
+			std::uint64_t lastUsed;
+			std::uint32_t generation;
+			bool alive;
+		};
+
+		struct Statistics
+		{
+			unsigned int assets;
+			unsigned int loading;
+			unsigned int evictions;
+			std::size_t cpuBytes;
+			std::size_t gpuBytes;
+		};
+
+	public:
+		AssetRegistry() : m_frame(0), m_statistics() {}
+
+	public:
+		//Adds a reference, created is set when the caller has to start loading the asset
+		Handle Acquire(const std::string & path, bool & created);
+		void AddReference(Handle handle);
+		void Release(Handle handle);
+
+	public:
+		void SetLoaded(Handle handle, std::unique_ptr<Asset> asset, std::size_t cpuBytes, std::size_t gpuBytes);
+		void SetFailed(Handle handle);
+		void Touch(Handle handle);
+		void NextFrame();
+
+		//Drops unreferenced assets, least recently used first, until the GPU bytes fit the budget.
+		//unload is called with each evicted asset before it is destroyed
+		template <typename Unload>
+		unsigned int Evict(std::size_t gpuBudget, Unload unload);
+
+		//Unloads everything regardless of references, for shutdown
+		template <typename Unload>
+		void Clear(Unload unload);
+
+	public:
+		bool IsValid(Handle handle) const;
+		Handle Find(const std::string & path) const;
+		Asset* Get(Handle handle) const;
+		const Entry* GetEntry(Handle handle) const;
+		const std::vector<Entry> & GetEntries() const;
+		const Statistics & GetStatistics() const;
+
+	public:
+		//Paths are compared case-insensitively with either slash
+		static std::uint64_t HashPath(const std::string & path);
+		static bool SamePath(const std::string & first, const std::string & second);
+
+	private:
+		Entry* Resolve(Handle handle);
+		void Remove(std::uint32_t index);
+
+	private:
+		std::vector<Entry> m_entries;
+		std::vector<std::uint32_t> m_free;
+		std::unordered_map<std::uint64_t, std::uint32_t> m_lookup;
+		std::uint64_t m_frame;
+		Statistics m_statistics;
+	};
+
+	template <typename Asset>
+	inline typename AssetRegistry<Asset>::Handle AssetRegistry<Asset>::Acquire(const std::string & path, bool & created)
+	{
+		std::uint64_t hash = HashPath(path);
+		auto found = m_lookup.find(hash);
+		bool collision = found != m_lookup.end() && !SamePath(m_entries[found->second].path, path);
+
+		//Requests for something already loaded or on its way share the same entry
+		if (found != m_lookup.end() && !collision)
+		{
+			Entry & entry = m_entries[found->second];
+			entry.references++;
+			entry.lastUsed = m_frame;
+			created = false;
+			return Handle(found->second, entry.generation);
+		}
+
+		std::uint32_t index;
+		if (!m_free.empty())
+		{
+			index = m_free.back();
+			m_free.pop_back();
+		}
+		else
+		{
+			index = (std::uint32_t)m_entries.size();
+			m_entries.push_back(Entry());
+			m_entries.back().generation = 0;
+		}
+
+		Entry & entry = m_entries[index];
+		entry.path = path;
+		entry.hash = hash;
+		entry.asset.reset();
+		entry.state = AssetStates::Loading;
+		entry.references = 1;
+		entry.cpuBytes = 0;
+		entry.gpuBytes = 0;
+		entry.lastUsed = m_frame;
+		entry.alive = true;
+
+		//Another path owns the hash, this asset still loads but isn't shared with later requests
+		if (!collision)
+			m_lookup[hash] = index;
+		m_statistics.assets++;
+		m_statistics.loading++;
+		created = true;
+
+		return Handle(index, entry.generation);
+	}
+
+	template <typename Asset>
+	inline void AssetRegistry<Asset>::AddReference(Handle handle)
+	{
+		Entry* entry = Resolve(handle);
+		if (entry)
+			entry->references++;
+	}
+
+	template <typename Asset>
+	inline void AssetRegistry<Asset>::Release(Handle handle)
+	{
+		//Unreferenced assets stay resident until the budget asks for the memory
+		Entry* entry = Resolve(handle);
+		if (entry && entry->references > 0)
+			entry->references--;
+	}
+
+	template <typename Asset>
+	inline void AssetRegistry<Asset>::SetLoaded(Handle handle, std::unique_ptr<Asset> asset, std::size_t cpuBytes, std::size_t gpuBytes)
+	{
+		Entry* entry = Resolve(handle);
+		if (!entry)
+			return;
+
+		if (entry->state == AssetStates::Loading)
+			m_statistics.loading--;
+
+		m_statistics.cpuBytes += cpuBytes - entry->cpuBytes;
+		m_statistics.gpuBytes += gpuBytes - entry->gpuBytes;
+
+		entry->asset = std::move(asset);
+		entry->state = AssetStates::Loaded;
+		entry->cpuBytes = cpuBytes;
+		entry->gpuBytes = gpuBytes;
+	}
+
+	template <typename Asset>
+	inline void AssetRegistry<Asset>::SetFailed(Handle handle)
+	{
+		Entry* entry = Resolve(handle);
+		if (!entry || entry->state != AssetStates::Loading)
+			return;
+
+		entry->state = AssetStates::Failed;
+		m_statistics.loading--;
+	}
+
+	template <typename Asset>
+	inline void AssetRegistry<Asset>::Touch(Handle handle)
+	{
+		Entry* entry = Resolve(handle);
+		if (entry)
+			entry->lastUsed = m_frame;
+	}
+
+	template <typename Asset>
+	inline void AssetRegistry<Asset>::NextFrame()
+	{
+		m_frame++;
+	}
+
+	template <typename Asset>
+	template <typename Unload>
+	inline unsigned int AssetRegistry<Asset>::Evict(std::size_t gpuBudget, Unload unload)
+	{
+		unsigned int evicted = 0;
+
+		while (m_statistics.gpuBytes > gpuBudget)
+		{
+			//Linear scan, the registry holds a few hundred assets at most
+			std::uint32_t oldest = Handle::INVALID_INDEX;
+			for (std::uint32_t i = 0; i < m_entries.size(); i++)
+			{
+				const Entry & entry = m_entries[i];
+				if (!entry.alive || entry.references > 0 || entry.state != AssetStates::Loaded)
+					continue;
+
+				if (oldest == Handle::INVALID_INDEX || entry.lastUsed < m_entries[oldest].lastUsed)
+					oldest = i;
+			}
+
+			//Everything left is in use, the budget is exceeded until something is released
+			if (oldest == Handle::INVALID_INDEX)
+				break;
+
+			unload(*m_entries[oldest].asset);
+			Remove(oldest);
+			evicted++;
+		}
+
+		m_statistics.evictions += evicted;
+		return evicted;
+	}
+
+	template <typename Asset>
+	template <typename Unload>
+	inline void AssetRegistry<Asset>::Clear(Unload unload)
+	{
+		for (std::uint32_t i = 0; i < m_entries.size(); i++)
+		{
+			if (!m_entries[i].alive)
+				continue;
+
+			if (m_entries[i].asset)
+				unload(*m_entries[i].asset);
+			Remove(i);
+		}
+	}
+
+	template <typename Asset>
+	inline bool AssetRegistry<Asset>::IsValid(Handle handle) const
+	{
+		return handle.index < m_entries.size() && m_entries[handle.index].alive && m_entries[handle.index].generation == handle.generation;
+	}
+
+	template <typename Asset>
+	inline typename AssetRegistry<Asset>::Handle AssetRegistry<Asset>::Find(const std::string & path) const
+	{
+		auto found = m_lookup.find(HashPath(path));
+		if (found == m_lookup.end() || !SamePath(m_entries[found->second].path, path))
+			return Handle();
+
+		return Handle(found->second, m_entries[found->second].generation);
+	}
+
+	template <typename Asset>
+	inline Asset* AssetRegistry<Asset>::Get(Handle handle) const
+	{
+		if (!IsValid(handle))
+			return nullptr;
+
+		return m_entries[handle.index].asset.get();
+	}
+
+	template <typename Asset>
+	inline const typename AssetRegistry<Asset>::Entry* AssetRegistry<Asset>::GetEntry(Handle handle) const
+	{
+		return IsValid(handle) ? &m_entries[handle.index] : nullptr;
+	}
+
+	template <typename Asset>
+	inline const std::vector<typename AssetRegistry<Asset>::Entry> & AssetRegistry<Asset>::GetEntries() const
+	{
+		return m_entries;
+	}
+
+	template <typename Asset>
+	inline const typename AssetRegistry<Asset>::Statistics & AssetRegistry<Asset>::GetStatistics() const
+	{
+		return m_statistics;
+	}
+
+	template <typename Asset>
+	inline std::uint64_t AssetRegistry<Asset>::HashPath(const std::string & path)
+	{
+		//FNV-1a over the normalized path
+		std::uint64_t hash = 14695981039346656037ull;
+
+		for (char c : path)
+		{
+			char normalized = (c == '\\') ? '/' : (char)std::tolower((unsigned char)c);
+			hash = (hash ^ (unsigned char)normalized) * 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	template <typename Asset>
+	inline bool AssetRegistry<Asset>::SamePath(const std::string & first, const std::string & second)
+	{
+		if (first.size() != second.size())
+			return false;
+
+		for (std::size_t i = 0; i < first.size(); i++)
+		{
+			char a = (first[i] == '\\') ? '/' : (char)std::tolower((unsigned char)first[i]);
+			char b = (second[i] == '\\') ? '/' : (char)std::tolower((unsigned char)second[i]);
+			if (a != b)
+				return false;
+		}
+
+		return true;
+	}
+
+	template <typename Asset>
+	inline typename AssetRegistry<Asset>::Entry* AssetRegistry<Asset>::Resolve(Handle handle)
+	{
+		return IsValid(handle) ? &m_entries[handle.index] : nullptr;
+	}
+
+	template <typename Asset>
+	inline void AssetRegistry<Asset>::Remove(std::uint32_t index)
+	{
+		Entry & entry = m_entries[index];
+
+		m_statistics.assets--;
+		m_statistics.cpuBytes -= entry.cpuBytes;
+		m_statistics.gpuBytes -= entry.gpuBytes;
+		if (entry.state == AssetStates::Loading)
+			m_statistics.loading--;
+
+		//Bumping the generation turns every handle still pointing here into a stale one
+		auto found = m_lookup.find(entry.hash);
+		if (found != m_lookup.end() && found->second == index)
+			m_lookup.erase(found);
+		entry.asset.reset();
+		entry.path.clear();
+		entry.alive = false;
+		entry.generation++;
+		m_free.push_back(index);
+	}
+}
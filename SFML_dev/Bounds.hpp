@@ -0,0 +1,57 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cfloat>
+
+namespace px
+{
+	struct BoundingBox
+	{
+		BoundingBox() : min(FLT_MAX), max(-FLT_MAX) {}
+
+		void Expand(const glm::vec3 & point)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+		glm::vec3 GetExtent() const { return max - min; }
+		bool IsValid() const { return min.x <= max.x; }
+
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	struct BoundingSphere
+	{
+		BoundingSphere() : center(0.f), radius(0.f) {}
+		BoundingSphere(glm::vec3 center, float radius) : center(center), radius(radius) {}
+
+		//Smallest sphere enclosing both spheres
+		static BoundingSphere Merge(const BoundingSphere & a, const BoundingSphere & b)
+		{
+			glm::vec3 offset = b.center - a.center;
+			float distance = glm::length(offset);
+
+			if (distance + b.radius <= a.radius)
+				return a;
+			if (distance + a.radius <= b.radius)
+				return b;
+
+			float radius = (distance + a.radius + b.radius) * 0.5f;
+			glm::vec3 center = a.center + offset * ((radius - a.radius) / distance);
+			return BoundingSphere(center, radius);
+		}
+
+		//Sphere of a transformed object, non-uniform scale grows the radius by the largest axis
+		BoundingSphere Transform(const glm::mat4 & world) const
+		{
+			float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+			return BoundingSphere(glm::vec3(world * glm::vec4(center, 1.f)), radius * scale);
+		}
+
+		glm::vec3 center;
+		float radius;
+	};
+}
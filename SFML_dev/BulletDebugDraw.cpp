@@ -1,69 +1,49 @@
 #include "BulletDebugDraw.hpp"
 #include <glad/glad.h>
-#include "Camera.hpp"
-#include "Shader.hpp"
 
 namespace px
 {
-	BulletDebugDraw::BulletDebugDraw(std::shared_ptr<Camera> & camera) : m_camera(camera)
+	BulletDebugDraw::BulletDebugDraw() : m_debugMode(0), m_droppedLines(0)
 	{
-		//Initial data
-		m_lines.push_back({ glm::vec3(1.f, 0.f, 0.f) }); //Line start
-		m_lines.push_back({ glm::vec3(1.f, 0.f, 0.f) }); //Line end
+		m_statistics.lines = 0;
+		m_statistics.droppedLines = 0;
+		m_statistics.overflowFrames = 0;
 
-		glGenVertexArrays(1, &m_VAO);
-		glGenBuffers(1, &m_VBO);
+		m_lines.reserve(4096);
 
+		glGenVertexArrays(1, &m_VAO);
 		glBindVertexArray(m_VAO);
 
-		glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-		glBufferData(GL_ARRAY_BUFFER, m_lines.size() * sizeof(LineVertex), &m_lines[0], GL_DYNAMIC_DRAW);
-
-		//Positions
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)0);
+		//The format is fixed, the stream buffer and its offset are bound per flush
 		glEnableVertexAttribArray(0);
+		glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(LineVertex, pos));
+		glVertexAttribBinding(0, 0);
 
-		//Colors
 		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, color));
+		glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(LineVertex, color));
+		glVertexAttribBinding(1, 0);
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindVertexArray(0);
+
+		m_stream = std::make_unique<StreamBuffer>("BulletDebugDraw lines", 4096 * sizeof(LineVertex));
 	}
 
 	BulletDebugDraw::~BulletDebugDraw()
 	{
 		glDeleteVertexArrays(1, &m_VAO);
-		glDeleteBuffers(1, &m_VBO);
 	}
 
 	void BulletDebugDraw::drawLine(const btVector3 & from, const btVector3 & to, const btVector3 & fromColor, const btVector3 & toColor)
 	{
-		Shader::Use(Shaders::Debug);
-
-		m_lines[0].pos = glm::vec3(from.x(), from.y(), from.z());
-		m_lines[0].color = glm::vec3(fromColor.x(), fromColor.y(), fromColor.z());
-		m_lines[1].pos = glm::vec3(to.x(), to.y(), to.z());
-		m_lines[1].color = glm::vec3(toColor.x(), toColor.y(), toColor.z());
-
-		glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-		glBufferData(GL_ARRAY_BUFFER, m_lines.size() * sizeof(LineVertex), &m_lines[0], GL_DYNAMIC_DRAW);
-
-		//Positions
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)0);
-		glEnableVertexAttribArray(0);
-
-		//Colors
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, color));
-
-		Shader::SetMatrix4x4(Shaders::Debug, "model", glm::mat4());
-		Shader::SetMatrix4x4(Shaders::Debug, "projection", m_camera->GetProjectionMatrix());
-		Shader::SetMatrix4x4(Shaders::Debug, "view", m_camera->GetViewMatrix());
-
-		glBindVertexArray(m_VAO);
-		glDrawArrays(GL_LINES, 0, m_lines.size());
-		glBindVertexArray(0);
+		//Only batch here, everything is uploaded and drawn at once in Flush()
+		if (m_lines.size() + 2 > MAX_DEBUG_VERTICES)
+		{
+			m_droppedLines++;
+			return;
+		}
+
+		m_lines.push_back({ glm::vec3(from.x(), from.y(), from.z()), glm::vec3(fromColor.x(), fromColor.y(), fromColor.z()) });
+		m_lines.push_back({ glm::vec3(to.x(), to.y(), to.z()), glm::vec3(toColor.x(), toColor.y(), toColor.z()) });
 	}
 
 	void BulletDebugDraw::drawLine(const btVector3 & from, const btVector3 & to, const btVector3 & color)
@@ -73,15 +53,41 @@ namespace px
 
 	void BulletDebugDraw::drawSphere(const btVector3 & p, btScalar radius, const btVector3 & color)
 	{
-
+		//Three great circles, much cheaper than Bullet's default sphere patch
+		const unsigned int segments = 16;
+		const btScalar step = SIMD_2_PI / segments;
+
+		const btVector3 axes[3][2] =
+		{
+			{ btVector3(1, 0, 0), btVector3(0, 1, 0) },
+			{ btVector3(0, 1, 0), btVector3(0, 0, 1) },
+			{ btVector3(0, 0, 1), btVector3(1, 0, 0) }
+		};
+
+		for (unsigned int a = 0; a < 3; a++)
+		{
+			btVector3 previous = p + axes[a][0] * radius;
+			for (unsigned int i = 1; i <= segments; i++)
+			{
+				btScalar angle = step * i;
+				btVector3 current = p + (axes[a][0] * btCos(angle) + axes[a][1] * btSin(angle)) * radius;
+				drawLine(previous, current, color);
+				previous = current;
+			}
+		}
 	}
 
 	void BulletDebugDraw::drawTriangle(const btVector3 & a, const btVector3 & b, const btVector3 & c, const btVector3 & color, btScalar alpha)
 	{
+		//Wireframe only, the debug shader has no blending
+		drawLine(a, b, color);
+		drawLine(b, c, color);
+		drawLine(c, a, color);
 	}
 
 	void BulletDebugDraw::drawContactPoint(const btVector3 & PointOnB, const btVector3 & normalOnB, btScalar distance, int lifeTime, const btVector3 & color)
 	{
+		drawLine(PointOnB, PointOnB + normalOnB * distance, color);
 	}
 
 	void BulletDebugDraw::reportErrorWarning(const char * warningString)
@@ -97,4 +103,36 @@ namespace px
 		m_debugMode = debugMode;
 	}
 
-}
\ No newline at end of file
+	void BulletDebugDraw::Flush()
+	{
+		m_statistics.lines = (unsigned int)m_lines.size() / 2;
+		m_statistics.droppedLines = m_droppedLines;
+		if (m_droppedLines > 0)
+			m_statistics.overflowFrames++;
+
+		m_droppedLines = 0;
+
+		if (m_lines.empty())
+			return;
+
+		//Lines are already in world space, projection and view come from the frame constants
+		Shader::Use(Shaders::Debug);
+
+		m_stream->BeginFrame();
+		std::size_t offset = m_stream->Upload(m_lines.data(), m_lines.size() * sizeof(LineVertex), sizeof(LineVertex));
+
+		glBindVertexArray(m_VAO);
+		glBindVertexBuffer(0, m_stream->GetBuffer(), offset, sizeof(LineVertex));
+		glDrawArrays(GL_LINES, 0, (GLsizei)m_lines.size());
+		glBindVertexArray(0);
+
+		m_stream->EndFrame();
+
+		m_lines.clear();
+	}
+
+	const BulletDebugDraw::Statistics & BulletDebugDraw::GetStatistics() const
+	{
+		return m_statistics;
+	}
+}
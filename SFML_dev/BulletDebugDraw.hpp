@@ -3,19 +3,29 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "Shader.hpp"
+#include "StreamBuffer.hpp"
 
 #include <memory>
 #include <vector>
 
 namespace px
 {
-	class Camera;
-	class Shader;
+	//Upper bound on the line vertices batched per frame, anything above it is dropped and counted
+	const unsigned int MAX_DEBUG_VERTICES = 1 << 18;
 
 	class BulletDebugDraw : public btIDebugDraw
 	{
 	public:
-		BulletDebugDraw(std::shared_ptr<Camera> & camera);
+		struct Statistics
+		{
+			unsigned int lines;
+			unsigned int droppedLines;
+			unsigned int overflowFrames;
+		};
+
+	public:
+		BulletDebugDraw();
 		~BulletDebugDraw();
 
 	public:
@@ -30,6 +40,12 @@ namespace px
 		virtual void setDebugMode(int debugMode);
 		virtual int getDebugMode() const { return m_debugMode; }
 
+	public:
+		void Flush();
+
+	public:
+		const Statistics & GetStatistics() const;
+
 	private:
 		struct LineVertex
 		{
@@ -37,10 +53,12 @@ namespace px
 			glm::vec3 color;
 		};
 
-		unsigned int m_VAO, m_VBO;
+		unsigned int m_VAO;
+		std::unique_ptr<StreamBuffer> m_stream;
 		int m_debugMode;
 		std::vector<LineVertex> m_lines;
-		std::shared_ptr<Camera> m_camera;
+		Statistics m_statistics;
+		unsigned int m_droppedLines;
 	};
 
 }
@@ -0,0 +1,39 @@
+#include "FrameConstants.hpp"
+#include "Camera.hpp"
+#include "GpuMemory.hpp"
+
+namespace px
+{
+	FrameConstants::FrameConstants()
+	{
+		glGenBuffers(1, &m_UBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), NULL, GL_DYNAMIC_DRAW);
+		GpuMemory::Register(GpuResources::Buffer, m_UBO, sizeof(FrameData), "FrameConstants");
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		//The block stays bound to its binding point for the lifetime of the buffer
+		glBindBufferBase(GL_UNIFORM_BUFFER, UniformBlocks::Frame, m_UBO);
+	}
+
+	FrameConstants::~FrameConstants()
+	{
+		GpuMemory::Unregister(GpuResources::Buffer, m_UBO);
+		glDeleteBuffers(1, &m_UBO);
+	}
+
+	void FrameConstants::Update(const Camera & camera, glm::vec3 lightDirection, float ambient, float specular)
+	{
+		FrameData data;
+		data.projection = camera.GetProjectionMatrix();
+		data.view = camera.GetViewMatrix();
+		data.viewPos = camera.GetPosition();
+		data.ambientStrength = ambient;
+		data.direction = lightDirection;
+		data.specularStrength = specular;
+
+		glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace px
+{
+	class Camera;
+
+	//Fixed binding points for uniform blocks, must match the layout qualifiers in the shaders
+	namespace UniformBlocks
+	{
+		enum ID
+		{
+			Frame = 0
+		};
+	}
+
+	//Camera and lighting data shared by every built-in program, uploaded once per frame
+	class FrameConstants
+	{
+	public:
+		FrameConstants();
+		~FrameConstants();
+
+	public:
+		void Update(const Camera & camera, glm::vec3 lightDirection, float ambient, float specular);
+
+	private:
+		//Mirrors the std140 "FrameData" block
+		struct FrameData
+		{
+			glm::mat4 projection;
+			glm::mat4 view;
+			glm::vec3 viewPos;
+			float ambientStrength;
+			glm::vec3 direction;
+			float specularStrength;
+		};
+
+		static_assert(sizeof(FrameData) == 160, "FrameData has to match the std140 layout");
+
+	private:
+		unsigned int m_UBO;
+	};
+}
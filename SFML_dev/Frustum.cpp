@@ -0,0 +1,89 @@
+#include "Frustum.hpp"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define PX_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace px
+{
+	Frustum::Frustum()
+	{
+		for (unsigned int i = 0; i < 8; i++)
+			m_a[i] = m_b[i] = m_c[i] = m_d[i] = 0.f;
+	}
+
+	void Frustum::Extract(const glm::mat4 & viewProjection)
+	{
+		//Gribb/Hartmann: planes are sums and differences of the matrix rows (glm is column major)
+		glm::vec4 rows[4];
+		for (unsigned int i = 0; i < 4; i++)
+			rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+		glm::vec4 planes[6] =
+		{
+			rows[3] + rows[0], //Left
+			rows[3] - rows[0], //Right
+			rows[3] + rows[1], //Bottom
+			rows[3] - rows[1], //Top
+			rows[3] + rows[2], //Near
+			rows[3] - rows[2]  //Far
+		};
+
+		for (unsigned int i = 0; i < 6; i++)
+		{
+			float length = glm::length(glm::vec3(planes[i]));
+			planes[i] /= length;
+
+			m_a[i] = planes[i].x;
+			m_b[i] = planes[i].y;
+			m_c[i] = planes[i].z;
+			m_d[i] = planes[i].w;
+		}
+	}
+
+	void Frustum::CullSpheres(const float * x, const float * y, const float * z, const float * radius, std::size_t count, std::uint8_t * visible) const
+	{
+		std::size_t i = 0;
+
+#ifdef PX_FRUSTUM_SSE
+		//Four spheres against one plane per iteration, a sphere is out once it is fully behind any plane
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 sx = _mm_loadu_ps(x + i);
+			__m128 sy = _mm_loadu_ps(y + i);
+			__m128 sz = _mm_loadu_ps(z + i);
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+			__m128 inside = _mm_cmpeq_ps(sx, sx);
+
+			for (unsigned int p = 0; p < 6; p++)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, _mm_set1_ps(m_a[p])), _mm_mul_ps(sy, _mm_set1_ps(m_b[p]))),
+											 _mm_add_ps(_mm_mul_ps(sz, _mm_set1_ps(m_c[p])), _mm_set1_ps(m_d[p])));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			visible[i + 0] = (std::uint8_t)((mask >> 0) & 1);
+			visible[i + 1] = (std::uint8_t)((mask >> 1) & 1);
+			visible[i + 2] = (std::uint8_t)((mask >> 2) & 1);
+			visible[i + 3] = (std::uint8_t)((mask >> 3) & 1);
+		}
+#endif
+
+		//Remainder, or everything without SSE
+		for (; i < count; i++)
+			visible[i] = IsVisible(glm::vec3(x[i], y[i], z[i]), radius[i]) ? 1 : 0;
+	}
+
+	bool Frustum::IsVisible(const glm::vec3 & center, float radius) const
+	{
+		for (unsigned int p = 0; p < 6; p++)
+		{
+			if (m_a[p] * center.x + m_b[p] * center.y + m_c[p] * center.z + m_d[p] < -radius)
+				return false;
+		}
+
+		return true;
+	}
+}
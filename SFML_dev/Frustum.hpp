@@ -0,0 +1,28 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstddef>
+
+namespace px
+{
+	//View frustum as six planes, tests spheres in batches of four with SSE when available
+	class Frustum
+	{
+	public:
+		Frustum();
+
+	public:
+		void Extract(const glm::mat4 & viewProjection);
+		void CullSpheres(const float* x, const float* y, const float* z, const float* radius, std::size_t count, std::uint8_t* visible) const;
+
+	public:
+		bool IsVisible(const glm::vec3 & center, float radius) const;
+
+	private:
+		//Planes in structure-of-arrays form, ax + by + cz + d >= 0 is inside
+		alignas(16) float m_a[8];
+		alignas(16) float m_b[8];
+		alignas(16) float m_c[8];
+		alignas(16) float m_d[8];
+	};
+}
@@ -8,12 +8,31 @@
 #include <assert.h>
 #include <iostream>
 #include <functional>
+#include <algorithm>
 
-//#define STB_IMAGE_IMPLEMENTATION
-//#include <stb_image.h>
+AppLog gameLog;
 
 namespace px
 {
+	namespace
+	{
+		struct ShaderFiles
+		{
+			Shaders::ID id;
+			const char* vertexPath;
+			const char* fragmentPath;
+		};
+
+		const ShaderFiles SHADER_FILES[] =
+		{
+			{ Shaders::Phong, "triangle.vertex", "triangle.fragment" },
+			{ Shaders::Grid, "grid.vertex", "grid.fragment" },
+			{ Shaders::Debug, "bulletDebug.vertex", "bulletDebug.fragment" }
+		};
+
+		const unsigned int SHADER_COUNT = sizeof(SHADER_FILES) / sizeof(SHADER_FILES[0]);
+	}
+
 	//Static functions
 	float Game::m_lastX = (float)WINDOW_WIDTH / 2.f;
 	float Game::m_lastY = (float)WINDOW_HEIGHT / 2.f;
@@ -22,45 +41,57 @@ namespace px
 	Game::EntityInformation Game::m_info;
 	Game::DisplayInformation Game::m_displayInfo;
 
-	Game::Game() : m_frameTime(0.f), m_creationCounter(0)
+	Game::Game() : m_frameTime(0.f)
 	{
-		glfwInit();
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-		glfwWindowHint(GLFW_SAMPLES, 4);
-
-		m_window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Pixel Engine", nullptr, nullptr);
-		assert(m_window != nullptr);
-
-		glfwSetWindowPos(m_window, 100, 75);
-		glfwMakeContextCurrent(m_window);
-
-		assert(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress));
-
-		//Callbacks
-		glfwSetFramebufferSizeCallback(m_window, OnFrameBufferResizeCallback);
-		glfwSetCursorPosCallback(m_window, OnMouseCallback);
-
-		//ImGUI initialize
-		InitImGuiStyle(true, 0.9f);
-		ImGui_ImplGlfwGL3_Init(m_window, true);
+		//Model and texture loads finish on the pool, startup runs its file reads and parsing there as well.
+		//Short per-frame work goes to the job system instead, so it never queues up behind a file load
+		JobSystem::Init();
+		m_threadPool = std::make_shared<ThreadPool>();
+		m_startup = std::make_unique<TaskGraph>(m_threadPool);
 
-		//Override imgui mouse button callback
-		glfwSetMouseButtonCallback(m_window, OnMouseButtonCallback);
+		InitScene();
+		m_startup->Run();
 
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_MULTISAMPLE);
+		gameLog.Print("Startup took %.2f ms, %.2f ms of work across %u tasks\n", m_startup->GetTotalTime(), m_startup->GetSerialTime(),
+			(unsigned int)m_startup->GetTimings().size());
 
-		InitScene();
+		//Lightning
+		m_lightDirection = glm::vec3(-0.2f, -1.0f, -0.3f); m_ambient = 0.3f; m_specular = 0.2f;
 
 		//Lua functions
 		gameConsole.lua.set_function("setCamera", [](float x, float y, float z) { m_scene->GetCamera()->SetPosition(glm::vec3(x, y, z)); });
 		gameConsole.lua.set_function("print", [] { gameConsole.AddLog("Printed"); });
+		gameConsole.lua.set_function("writeStartupTrace", [this](std::string path)
+		{
+			if (m_startup->WriteTrace(path))
+				gameConsole.AddLog("Startup trace written to %s, open it in chrome://tracing", path.c_str());
+			else
+				gameConsole.AddLog("Could not write %s", path.c_str());
+		});
+		gameConsole.lua.set_function("setParent", [](std::string name, std::string parent)
+		{
+			if (!m_scene->SetParent(name, parent))
+				gameConsole.AddLog("Can't parent %s to %s", name.c_str(), parent.c_str());
+		});
+		gameConsole.lua.set_function("benchmarkJobs", []
+		{
+			gameConsole.AddLog("Job system with %u threads", JobSystem::GetThreadCount());
+			for (const JobBenchmark & result : JobSystem::RunBenchmarks())
+			{
+				gameConsole.AddLog("%s (%u jobs): %.3f ms serial, %.3f ms parallel (%.2fx)", result.name.c_str(), result.jobs, result.serialTime,
+					result.parallelTime, result.serialTime / result.parallelTime);
+			}
+		});
+		gameConsole.lua.set_function("benchmarkTransforms", [](unsigned int count)
+		{
+			TransformStore::BenchmarkResult result = TransformStore::RunBenchmark(count);
+			gameConsole.AddLog("%u transforms: %.2f ms per object, %.2f ms batched (%.1fx), %.2f ms batched on %u threads (%.1fx), max difference %g",
+				result.count, result.scalarTime, result.batchTime, result.scalarTime / result.batchTime, result.parallelTime, JobSystem::GetThreadCount(),
+				result.scalarTime / result.parallelTime, result.maxError);
+		});
 
 		//Init some GUI info
 		m_info.picked = false;
-		m_info.selectedEntity = 0;
 
 		m_displayInfo.hovered = false;
 		m_displayInfo.showGrid = true;
@@ -68,6 +99,8 @@ namespace px
 		m_displayInfo.showCameraPosition = true;
 		m_displayInfo.showDiagnostics = false;
 		m_displayInfo.showDebugDraw = true;
+		m_displayInfo.resourceSortColumn = 3;
+		m_displayInfo.resourceSortDescending = true;
 
 		//Materials test
 		Material material;
@@ -89,47 +122,135 @@ namespace px
 		m_scene->WriteSceneData();
 		m_scene->DestroyScene();
 
-		//TODO: make function to destroy all loaded models?
-		m_models->Destroy(Models::Cube);
-		//m_models->Destroy(Models::Capsule);
-		m_models->Destroy(Models::Sphere);
-		m_models->Destroy(Models::Cylinder);
+		//The scene is static, its stream buffers would otherwise outlive the GL context and the allocation registry
+		m_scene.reset();
+		m_frameConstants.reset();
+		m_grid.reset();
+		m_frameBuffer.reset();
+
+		m_models->Clear();
+		m_textures->Clear();
 
+		JobSystem::Release();
 		Physics::Release();
+		GeometryBuffer::Release();
 		ImGui_ImplGlfwGL3_Shutdown();
 		glfwTerminate();
 	}
 
+	void Game::InitWindow()
+	{
+		glfwInit();
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_SAMPLES, 4);
+
+		m_window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Pixel Engine", nullptr, nullptr);
+		assert(m_window != nullptr);
+
+		glfwSetWindowPos(m_window, 100, 75);
+		glfwMakeContextCurrent(m_window);
+
+		assert(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress));
+
+		//Callbacks
+		glfwSetFramebufferSizeCallback(m_window, OnFrameBufferResizeCallback);
+		glfwSetCursorPosCallback(m_window, OnMouseCallback);
+
+		glEnable(GL_DEPTH_TEST);
+		glEnable(GL_MULTISAMPLE);
+	}
+
+	void Game::InitImGui()
+	{
+		//ImGUI initialize
+		InitImGuiStyle(true, 0.9f);
+		ImGui_ImplGlfwGL3_Init(m_window, true);
+
+		//Override imgui mouse button callback
+		glfwSetMouseButtonCallback(m_window, OnMouseButtonCallback);
+	}
+
 	void Game::LoadShaders()
 	{
-		Shader::LoadShaders(Shaders::Phong, "triangle.vertex", "triangle.fragment");
-		Shader::LoadShaders(Shaders::Grid, "grid.vertex", "grid.fragment");
-		Shader::LoadShaders(Shaders::Debug, "bulletDebug.vertex", "bulletDebug.fragment");
+		//Sources were read on the pool, only compiling or loading the binaries needs the context
+		for (unsigned int i = 0; i < SHADER_COUNT; i++)
+			Shader::LoadShaders(SHADER_FILES[i].id, m_shaderSources[i]);
+
+		m_shaderSources.clear();
+
+		const Shader::CacheStatistics & cache = Shader::GetCacheStatistics();
+		gameLog.Print("Shader cache: %u hit(s), %u miss(es), loaded in %.2f ms, compiled in %.2f ms, saved %.2f ms\n",
+			cache.hits, cache.misses, cache.loadTime, cache.compileTime, cache.savedTime);
 	}
 
 	void Game::LoadModels()
 	{
-		m_models = std::make_shared<Model<Models::ID>>();
+		//Loads finish on the pool and are uploaded a bit per frame in Update()
+		m_models = std::make_shared<Model>(m_threadPool);
+
+		//Standard models, held for the whole session so the GameObject menu never waits on a load
+		m_builtinModels.push_back(m_models->Acquire(Models::Paths[Models::Cube]));
+		m_builtinModels.push_back(m_models->Acquire(Models::Paths[Models::Sphere]));
+		m_builtinModels.push_back(m_models->Acquire(Models::Paths[Models::Cylinder]));
+		//m_builtinModels.push_back(m_models->Acquire(Models::Paths[Models::Capsule]));
+	}
 
-		//Standard models
-		m_models->LoadModel(Models::Cube, "../res/Models/Cube/cube.obj");
-		m_models->LoadModel(Models::Sphere, "../res/Models/Sphere/sphere.obj");
-		m_models->LoadModel(Models::Cylinder, "../res/Models/Cylinder/cylinder.obj");
-		//m_models->LoadModel(Models::Capsule, "../res/Models/Capsule/capsule.obj");
+	void Game::LoadTextures()
+	{
+		//Cooked on the same pool as the models and streamed in from the smallest mip
+		m_textures = std::make_shared<Texture>(m_threadPool);
+		m_fileIcon = m_textures->Acquire("../res/images/fileIcon.png");
 	}
 
 	void Game::InitScene()
 	{
-		LoadShaders();
-		LoadModels();
+		//Startup as a graph: file reads and parsing run on the pool while the context thread creates the window,
+		//everything touching GL or the physics world stays on the thread that runs the graph
+		TaskGraph & startup = *m_startup;
 
-		m_scene = std::make_unique<Scene>();
-		m_scene->LoadScene(m_models);
-		m_frameBuffer = std::make_unique<RenderTexture>();
-		m_grid = std::make_unique<Grid>(m_scene->GetCamera());
+		TaskGraph::TaskID window = startup.Add("Create window", TaskThreads::Main, [this] { InitWindow(); });
+		startup.Add("Init ImGui", TaskThreads::Main, [this] { InitImGui(); }, { window });
 
-		//Lightning
-		m_lightDirection = glm::vec3(-0.2f, -1.0f, -0.3f); m_ambient = 0.3f; m_specular = 0.2f;
+		//The vertex format decides how the shaders decode positions and normals
+		TaskGraph::TaskID geometry = startup.Add("Geometry buffer", TaskThreads::Main, []
+		{
+			GeometryBuffer::Init(VertexFormats::Packed);
+			if (GeometryBuffer::GetVertexFormat() == VertexFormats::Packed)
+				Shader::AddDefine("PX_PACKED_VERTICES");
+		}, { window });
+
+		std::vector<TaskGraph::TaskID> shaderDependencies = { geometry };
+		m_shaderSources.resize(SHADER_COUNT);
+
+		for (unsigned int i = 0; i < SHADER_COUNT; i++)
+		{
+			shaderDependencies.push_back(startup.Add(std::string("Read ") + SHADER_FILES[i].vertexPath, TaskThreads::Worker, [this, i]
+			{
+				m_shaderSources[i] = Shader::ReadProgram(SHADER_FILES[i].vertexPath, SHADER_FILES[i].fragmentPath);
+			}));
+		}
+
+		TaskGraph::TaskID shaders = startup.Add("Load shaders", TaskThreads::Main, [this] { LoadShaders(); }, shaderDependencies);
+		TaskGraph::TaskID models = startup.Add("Load models", TaskThreads::Main, [this] { LoadModels(); }, { geometry });
+		startup.Add("Load textures", TaskThreads::Main, [this] { LoadTextures(); }, { window });
+
+		TaskGraph::TaskID parse = startup.Add("Parse scene", TaskThreads::Worker, []
+		{
+			m_scene = std::make_unique<Scene>();
+			m_scene->ReadScene();
+		});
+
+		TaskGraph::TaskID physics = startup.Add("Init physics", TaskThreads::Main, [] { Physics::Init(); }, { window });
+		startup.Add("Build scene", TaskThreads::Main, [this] { m_scene->LoadScene(m_models); }, { parse, models, physics, shaders });
+
+		startup.Add("Render targets", TaskThreads::Main, [this]
+		{
+			m_frameBuffer = std::make_unique<RenderTexture>();
+			m_grid = std::make_unique<Grid>();
+			m_frameConstants = std::make_unique<FrameConstants>();
+		}, { window });
 	}
 
 	void Game::Run()
@@ -154,8 +275,15 @@ namespace px
 			}
 
 			glfwPollEvents();
+			JobSystem::RunMainJobs();
+
+			//The simulation steps on a worker while the main thread finishes the pending uploads
+			JobCounter physics;
+			Physics::UpdateAsync(physics);
+			m_models->ProcessUploads();
+			m_textures->ProcessUploads();
+			JobSystem::Wait(physics);
 
-			Physics::Update();
 			UpdateGUI(deltaTime);
 			Update((float)deltaTime);
 
@@ -163,6 +291,8 @@ namespace px
 			ImGui::Render();
 
 			glfwSwapBuffers(m_window);
+			GpuMemory::NextFrame();
+			JobSystem::NextFrame();
 		}
 	}
 
@@ -173,17 +303,12 @@ namespace px
 		glClearColor(0.274f, 0.227f, 0.227f, 1.f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		//Camera and light are shared by all programs through one uniform block
+		m_frameConstants->Update(*m_scene->GetCamera(), m_lightDirection, m_ambient, m_specular);
+
 		if (m_displayInfo.showGrid)
 			m_grid->Draw(Shaders::Grid);
 
-		Shader::Use(Shaders::Phong);
-		Shader::SetMatrix4x4(Shaders::Phong, "projection", m_scene->GetCamera()->GetProjectionMatrix());
-		Shader::SetMatrix4x4(Shaders::Phong, "view", m_scene->GetCamera()->GetViewMatrix());
-		Shader::SetFloat3v(Shaders::Phong, "viewpos", m_scene->GetCamera()->GetPosition());
-		Shader::SetFloat3v(Shaders::Phong, "direction", m_lightDirection);
-		Shader::SetFloat(Shaders::Phong, "ambientStrength", m_ambient);
-		Shader::SetFloat(Shaders::Phong, "specularStrength", m_specular);
-
 		//Update systems
 		m_scene->UpdateSystems(dt);
 	
@@ -275,13 +400,13 @@ namespace px
 				if (ImGui::BeginMenu("3D Object"))
 				{
 					if(ImGui::MenuItem("Cube"))
-						m_scene->CreateEntity(m_models, Models::Cube, RigidBodyType::Box, GenerateName("Cube"));
+						m_scene->CreateEntity(Models::Paths[Models::Cube], RigidBodyType::Box, GenerateName("Cube"));
 
 					if (ImGui::MenuItem("Sphere"))
-						m_scene->CreateEntity(m_models, Models::Sphere, RigidBodyType::Sphere, GenerateName("Sphere"));
+						m_scene->CreateEntity(Models::Paths[Models::Sphere], RigidBodyType::Sphere, GenerateName("Sphere"));
 
 					if (ImGui::MenuItem("Cylinder"))
-						m_scene->CreateEntity(m_models, Models::Cylinder, RigidBodyType::Cylinder, GenerateName("Cylinder"));
+						m_scene->CreateEntity(Models::Paths[Models::Cylinder], RigidBodyType::Cylinder, GenerateName("Cylinder"));
 
 					/*if (ImGui::MenuItem("Capsule"))
 						m_scene->CreateEntity(m_models, Models::Capsule, PickingType::Capsule,  GenerateName("Capsule"));*/
@@ -330,7 +455,6 @@ namespace px
 			if (ImGui::Button("Yes", ImVec2(120, 0)) || glfwGetKey(m_window, GLFW_KEY_ENTER) == GLFW_PRESS)
 			{ 
 				m_scene->DestroyEntity(m_info.pickedName);
-				m_creationCounter = 0;
 				m_info.picked = false;
 				ImGui::CloseCurrentPopup(); 
 			}
@@ -373,6 +497,52 @@ namespace px
 				glGetString(GL_RENDERER)
 			);
 
+			const RenderSystem::Statistics & stats = m_scene->GetRenderStatistics();
+			ImGui::TextColored(ImVec4(0.f, 1.0f, 0.0f, 1.0f), "Render queue:\nObjects: %u (%u culled)\nPackets: %u\nIndirect commands: %u\nMulti-draws: %u\nShader changes: %u\nMesh changes: %u\nMaterial changes: %u\nLODs: %u / %u / %u / %u\n",
+				stats.objects, stats.culled, stats.queue.packets, stats.queue.drawCalls, stats.multiDraws, stats.queue.shaderChanges, stats.queue.meshChanges, stats.queue.materialChanges,
+				stats.lods[0], stats.lods[1], stats.lods[2], stats.lods[3]);
+
+			ImGui::TextColored(ImVec4(0.f, 1.0f, 0.0f, 1.0f), "Transforms updated: %u\n", m_scene->GetTransformUpdates());
+
+			//Share of the last frame each thread spent running jobs
+			const std::vector<JobStatistics> & jobStats = JobSystem::GetStatistics();
+			ImGui::TextColored(ImVec4(0.f, 1.0f, 0.0f, 1.0f), "Job system:");
+			for (unsigned int i = 0; i < jobStats.size(); i++)
+			{
+				const JobStatistics & stats = jobStats[i];
+				ImGui::ProgressBar(stats.utilization, ImVec2(120.f, 0.f));
+				ImGui::SameLine();
+				if (i == 0)
+					ImGui::Text("Main: %.2f ms, %u jobs, %u stolen", stats.busyTime, stats.jobs, stats.steals);
+				else
+					ImGui::Text("Worker %u: %.2f ms, %u jobs, %u stolen", i, stats.busyTime, stats.jobs, stats.steals);
+			}
+			ImGui::Spacing();
+
+			ImGui::TextColored(ImVec4(0.f, 1.0f, 0.0f, 1.0f), "Geometry buffer:\nVertices: %u / %u\nIndex slots: %u / %u\nModels loading: %u\n",
+				GeometryBuffer::GetUsedVertices(), GeometryBuffer::GetVertexCapacity(), GeometryBuffer::GetUsedIndices(), GeometryBuffer::GetIndexCapacity(),
+				m_models->GetPendingLoads());
+
+			const Model::Registry::Statistics & assetStats = m_models->GetRegistry().GetStatistics();
+			ImGui::TextColored(ImVec4(0.f, 1.0f, 0.0f, 1.0f), "Assets:\nModels: %u (%u loading)\nGPU: %.2f / %.2f MB\nCPU: %.2f KB\nEvictions: %u\n",
+				assetStats.assets, assetStats.loading, assetStats.gpuBytes / (1024.0 * 1024.0), m_models->GetMemoryBudget() / (1024.0 * 1024.0),
+				assetStats.cpuBytes / 1024.0, assetStats.evictions);
+
+			const Texture::Registry::Statistics & textureStats = m_textures->GetRegistry().GetStatistics();
+			ImGui::TextColored(ImVec4(0.f, 1.0f, 0.0f, 1.0f), "Textures: %u (%u pending)\nGPU: %.2f / %.2f MB\nCompression: %s\nEvictions: %u\n",
+				textureStats.assets, m_textures->GetPendingLoads(), textureStats.gpuBytes / (1024.0 * 1024.0),
+				m_textures->GetMemoryBudget() / (1024.0 * 1024.0), m_textures->IsCompressionSupported() ? "BC1/BC3/BC5" : "BC5 only", textureStats.evictions);
+
+			const Shader::CacheStatistics & shaderCache = Shader::GetCacheStatistics();
+			ImGui::TextColored(ImVec4(0.f, 1.0f, 0.0f, 1.0f), "Shader cache:\nHits: %u\nMisses: %u\nSaved: %.2f ms\n",
+				shaderCache.hits, shaderCache.misses, shaderCache.savedTime);
+
+			const BulletDebugDraw::Statistics & debugStats = Physics::GetDebugDraw()->GetStatistics();
+			ImGui::TextColored(ImVec4(0.f, 1.0f, 0.0f, 1.0f), "Debug draw:\nLines: %u\nDropped: %u (%u frames over cap)\n",
+				debugStats.lines, debugStats.droppedLines, debugStats.overflowFrames);
+
+			GpuResourcesGUI();
+
 			ImGui::End();
 		}
 
@@ -434,11 +604,20 @@ namespace px
 			{		 
 				if (m_info.picked)
 				{
-					//TODO: make sure that entities can't have the same name!
-					//Change name of entity upon completion
+					//Change name of entity upon completion, names have to stay unique
 					if (ImGui::InputText("Name", m_info.nameChanger.data(), m_info.nameChanger.size(), ImGuiInputTextFlags_EnterReturnsTrue))
 					{
-						m_scene->ChangeEntityName(m_info.pickedName, m_info.nameChanger.data());
+						if (m_scene->ChangeEntityName(m_info.pickedName, m_info.nameChanger.data()))
+							m_info.pickedName = m_info.nameChanger.data();
+						else
+							gameLog.Print("Can't rename %s to %s, the name is taken\n", m_info.pickedName.c_str(), m_info.nameChanger.data());
+					}
+
+					//Transform values become relative to the new parent, an empty name detaches the entity
+					if (ImGui::InputText("Parent", m_info.parentChanger.data(), m_info.parentChanger.size(), ImGuiInputTextFlags_EnterReturnsTrue))
+					{
+						if (!m_scene->SetParent(m_info.pickedName, m_info.parentChanger.data()))
+							gameLog.Print("Can't parent %s to %s\n", m_info.pickedName.c_str(), m_info.parentChanger.data());
 					}
 					ImGui::Spacing();
 
@@ -476,33 +655,12 @@ namespace px
 			{
 				ImGui::BeginChild("Entities");
 
-				unsigned int i = 0;
-				ComponentHandle<Transformable> transform;
-				ComponentHandle<Renderable> renderable;
-
-				for (Entity & entity : m_scene->GetEntities().entities_with_components(transform, renderable))
+				//Roots at the top level, each one opens up into its children
+				ComponentHandle<Hierarchy> hierarchy;
+				for (Entity & entity : m_scene->GetEntities().entities_with_components(hierarchy))
 				{
-					char label[128];
-					sprintf(label, renderable->object->GetName().c_str());
-					if (ImGui::Selectable(label, m_info.selectedEntity == i))
-					{
-						//Give information to GUI about picked object
-						m_info.pickedName = renderable->object->GetName();
-						m_info.color = renderable->object->GetColor();
-
-						//Copy the name to the char vector
-						m_info.nameChanger.clear(); m_info.nameChanger.resize(50);
-						for (unsigned int p = 0; p < m_info.pickedName.size(); p++)
-							m_info.nameChanger[p] = m_info.pickedName[p];
-
-						//Give information to GUI about picked object
-						m_info.scale = transform->transform->GetScale();
-						m_info.position = transform->transform->GetPosition();
-						m_info.rotationAngles = transform->transform->GetRotationAngles();
-						m_info.selectedEntity = i;
-						m_info.picked = true;
-					}
-					i++;
+					if (hierarchy->parent == Entity::INVALID)
+						HierarchyGUI(entity);
 				}
 				ImGui::EndChild();
 			}
@@ -537,6 +695,40 @@ namespace px
 					}
 					ImGui::TreePop();
 				}
+
+				if (ImGui::TreeNode("Models"))
+				{
+					ImTextureID icon = (ImTextureID)(intptr_t)m_textures->GetTexture(m_fileIcon);
+					for (const auto & entry : m_models->GetRegistry().GetEntries())
+					{
+						if (entry.alive && entry.state != AssetStates::Failed)
+						{
+							ImGui::Image(icon, ImVec2(16.f, 16.f));
+							ImGui::SameLine();
+							ImGui::Text("%s%s", entry.path.c_str(), entry.state == AssetStates::Loading ? " (loading)" : "");
+						}
+					}
+					ImGui::TreePop();
+				}
+
+				if (ImGui::TreeNode("Textures"))
+				{
+					for (const auto & entry : m_textures->GetRegistry().GetEntries())
+					{
+						if (!entry.alive)
+							continue;
+
+						if (entry.state == AssetStates::Loaded && entry.asset)
+						{
+							const TextureAsset & texture = *entry.asset;
+							ImGui::Text("%s (%ux%u %s, mip %u/%u)", entry.path.c_str(), texture.width, texture.height,
+								TextureCache::GetFormatName(texture.format), texture.residentMip, texture.mipCount);
+						}
+						else if (entry.state == AssetStates::Loading)
+							ImGui::Text("%s (loading)", entry.path.c_str());
+					}
+					ImGui::TreePop();
+				}
 			}
 			ImGui::EndDock();
 
@@ -545,6 +737,120 @@ namespace px
 		ImGui::End();
 	}
 
+	void Game::GpuResourcesGUI()
+	{
+		const double MB = 1024.0 * 1024.0;
+		if (!ImGui::CollapsingHeader("GPU resources"))
+			return;
+
+		ImGui::TextColored(ImVec4(0.f, 1.0f, 0.0f, 1.0f), "Total: %.2f MB", GpuMemory::GetTotalBytes() / MB);
+		for (unsigned int type = 0; type < GpuResources::Count; type++)
+		{
+			GpuResources::ID id = (GpuResources::ID)type;
+			ImGui::TextColored(ImVec4(0.f, 1.0f, 0.0f, 1.0f), "%ss: %u, %.2f MB", GpuMemory::GetTypeName(id), GpuMemory::GetCount(id), GpuMemory::GetBytes(id) / MB);
+		}
+
+		//Sorted by the last clicked header, clicking it again flips the order
+		int column = m_displayInfo.resourceSortColumn;
+		bool descending = m_displayInfo.resourceSortDescending;
+
+		std::vector<const GpuAllocation*> allocations;
+		for (const auto & allocation : GpuMemory::GetAllocations())
+			allocations.push_back(&allocation.second);
+
+		std::stable_sort(allocations.begin(), allocations.end(), [column, descending](const GpuAllocation* a, const GpuAllocation* b)
+		{
+			if (descending)
+				std::swap(a, b);
+
+			switch (column)
+			{
+			case 0: return a->type < b->type;
+			case 1: return a->owner < b->owner;
+			case 2: return a->handle < b->handle;
+			case 3: return a->bytes < b->bytes;
+			default: return a->frame < b->frame;
+			}
+		});
+
+		const char* headers[] = { "Type", "Owner", "Handle", "Size", "Frame" };
+		ImGui::BeginChild("GpuResources", ImVec2(640.f, 240.f), true);
+		ImGui::Columns(5, "GpuResourceColumns");
+
+		for (int i = 0; i < 5; i++)
+		{
+			std::string label = std::string(headers[i]) + (i == column ? (descending ? " v" : " ^") : "");
+			if (ImGui::Selectable(label.c_str(), i == column))
+			{
+				m_displayInfo.resourceSortDescending = (i == column) ? !descending : true;
+				m_displayInfo.resourceSortColumn = i;
+			}
+			ImGui::NextColumn();
+		}
+		ImGui::Separator();
+
+		for (const GpuAllocation* allocation : allocations)
+		{
+			ImGui::Text("%s", GpuMemory::GetTypeName(allocation->type)); ImGui::NextColumn();
+			ImGui::Text("%s", allocation->owner.c_str()); ImGui::NextColumn();
+			ImGui::Text("%u", allocation->handle); ImGui::NextColumn();
+			ImGui::Text("%.1f KB", allocation->bytes / 1024.0); ImGui::NextColumn();
+			ImGui::Text("%llu", (unsigned long long)allocation->frame); ImGui::NextColumn();
+		}
+
+		ImGui::Columns(1);
+		ImGui::EndChild();
+	}
+
+	void Game::HierarchyGUI(Entity entity)
+	{
+		ComponentHandle<Hierarchy> hierarchy = entity.component<Hierarchy>();
+		const std::string & name = m_scene->GetName(entity.component<Renderable>()->name);
+
+		ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_DefaultOpen;
+		if (hierarchy->firstChild == Entity::INVALID)
+			flags |= ImGuiTreeNodeFlags_Leaf;
+		if (m_info.picked && m_info.pickedName == name)
+			flags |= ImGuiTreeNodeFlags_Selected;
+
+		bool open = ImGui::TreeNodeEx(name.c_str(), flags);
+		if (ImGui::IsItemClicked())
+			SelectEntity(entity);
+
+		if (open)
+		{
+			for (Entity::Id child = hierarchy->firstChild; child != Entity::INVALID; child = m_scene->GetEntities().component<Hierarchy>(child)->nextSibling)
+				HierarchyGUI(m_scene->GetEntities().get(child));
+
+			ImGui::TreePop();
+		}
+	}
+
+	void Game::SelectEntity(Entity entity)
+	{
+		//Give information to GUI about picked object
+		TransformID transform = entity.component<Transformable>()->id;
+		ComponentHandle<Renderable> renderable = entity.component<Renderable>();
+		TransformStore & transforms = m_scene->GetTransforms();
+
+		m_info.pickedName = m_scene->GetName(renderable->name);
+		m_info.color = m_scene->GetModels()->GetColor(renderable->model);
+		m_info.scale = transforms.GetScale(transform);
+		m_info.position = transforms.GetPosition(transform);
+		m_info.rotationAngles = transforms.GetRotationAngles(transform);
+		m_info.picked = true;
+
+		//Copy the names to the char vectors
+		m_info.nameChanger.clear(); m_info.nameChanger.resize(50);
+		for (unsigned int p = 0; p < m_info.pickedName.size(); p++)
+			m_info.nameChanger[p] = m_info.pickedName[p];
+
+		std::string parent = m_scene->GetParentName(m_info.pickedName);
+		m_info.parentChanger.clear(); m_info.parentChanger.resize(50);
+		for (unsigned int p = 0; p < parent.size(); p++)
+			m_info.parentChanger[p] = parent[p];
+	}
+
 	void Game::UpdateCamera(float dt)
 	{
 		//Camera movement
@@ -561,22 +867,7 @@ namespace px
 	std::string Game::GenerateName(std::string nameType)
 	{
 		//Generates a new name based on a type (sphere, cube, etc)
-		//This function is not safe as the name can sometimes already be taken
-		std::string name = nameType + std::to_string(m_creationCounter);
-		ComponentHandle<Renderable> renderable;
-
-		for (Entity & entity : m_scene->GetEntities().entities_with_components(renderable))
-		{
-			if (name != renderable->object->GetName())
-				name = name;
-			else
-			{
-				m_creationCounter++;
-				name = nameType + std::to_string(m_creationCounter);
-			}
-		}
-
-		return name;
+		return m_scene->MakeUniqueName(nameType);
 	}
 
 	//*** Callbacks ***
@@ -617,36 +908,17 @@ namespace px
 			{
 				Picking::PerformMousePicking(m_scene->GetCamera(), m_lastX - 16, m_lastY - 50);
 
-				ComponentHandle<Transformable> transform;
-				ComponentHandle<Renderable> renderable;
 				ComponentHandle<Pickable> pickable;
-
-				unsigned int i = 0;
-				for (Entity & entity : m_scene->GetEntities().entities_with_components(transform, renderable, pickable))
+				for (Entity & entity : m_scene->GetEntities().entities_with_components(pickable))
 				{
-					if (Picking::RayCast(FAR_PLANE, pickable->object->GetRigidBody()))
+					if (Picking::RayCast(FAR_PLANE, pickable->body))
 					{
-						//Give information to GUI about picked object
-						m_info.selectedEntity = i;
-						m_info.pickedName = renderable->object->GetName();
-						m_info.color = renderable->object->GetColor();
-						m_info.scale = transform->transform->GetScale();
-						m_info.position = transform->transform->GetPosition();
-						m_info.rotationAngles = transform->transform->GetRotationAngles();
-						m_info.picked = true;
-
-						//Copy the name to the char vector
-						m_info.nameChanger.clear(); m_info.nameChanger.resize(50);
-						for (unsigned int p = 0; p < m_info.pickedName.size(); p++)
-							m_info.nameChanger[p] = m_info.pickedName[p];
-
+						SelectEntity(entity);
 						gameLog.Print("Picked\n");
 						break;
 					}
 					else
 						m_info.picked = false;
-
-					i++;
 				}
 			}
 		}
@@ -1,8 +1,14 @@
 #pragma once
 #include "Picking.hpp"
 #include "Grid.hpp"
+#include "FrameConstants.hpp"
 #include "RenderTexture.hpp"
 #include "Scene.hpp"
+#include "Texture.hpp"
+#include "ThreadPool.hpp"
+#include "TaskGraph.hpp"
+#include "JobSystem.hpp"
+#include "GpuMemory.hpp"
 
 #include <GLFW/glfw3.h>
 #include <memory>
@@ -22,10 +28,15 @@ namespace px
 		void Update(float dt);
 		void Render(double dt);
 		void SceneGUI(double dt);
+		void InitWindow();
+		void InitImGui();
 		void LoadShaders();
 		void LoadModels();
+		void LoadTextures();
 		void InitScene();
 		void UpdateGUI(double dt);
+		void GpuResourcesGUI();
+		void HierarchyGUI(Entity entity);
 		void UpdateCamera(float dt);
 		std::string GenerateName(std::string nameType);
 
@@ -33,6 +44,7 @@ namespace px
 		static void OnFrameBufferResizeCallback(GLFWwindow* window, int width, int height);
 		static void OnMouseCallback(GLFWwindow* window, double xpos, double ypos);
 		static void OnMouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+		static void SelectEntity(Entity entity);
 		//static void OnMouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 
 	private:
@@ -45,7 +57,6 @@ namespace px
 		//Struct for providing information about an entity to the GUI
 		struct EntityInformation
 		{
-			int selectedEntity;
 			bool picked;
 			std::string pickedName;
 			glm::vec3 rotationAngles;
@@ -53,6 +64,7 @@ namespace px
 			glm::vec3 scale;
 			glm::vec3 color;
 			std::vector<char> nameChanger;
+			std::vector<char> parentChanger;
 		};
 
 		//Struct for managing display settings in the GUI
@@ -64,6 +76,10 @@ namespace px
 			bool hovered;
 			bool showDiagnostics;
 			bool showDebugDraw;
+
+			//Column the GPU resource table is sorted by
+			int resourceSortColumn;
+			bool resourceSortDescending;
 		};
 
 	private:
@@ -77,14 +93,20 @@ namespace px
 		static std::vector<Material> m_materials;
 			
 	private:
-		int m_creationCounter;
 		bool* m_open;
 		float m_frameTime;
 		GLFWwindow* m_window;
 		std::vector<char*> m_materialNames;
 		std::unique_ptr<Grid> m_grid;
+		std::unique_ptr<FrameConstants> m_frameConstants;
 		std::unique_ptr<RenderTexture> m_frameBuffer;
+		std::shared_ptr<ThreadPool> m_threadPool;
+		std::unique_ptr<TaskGraph> m_startup;
+		std::vector<ProgramSource> m_shaderSources;
 		ModelHolder m_models;
+		std::vector<ModelHandle> m_builtinModels;
+		TextureHolder m_textures;
+		TextureHandle m_fileIcon;
 
 	private:
 		//Lightning variables
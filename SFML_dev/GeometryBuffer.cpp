@@ -0,0 +1,393 @@
+#include "GeometryBuffer.hpp"
+#include "GpuMemory.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace px
+{
+	unsigned int GeometryBuffer::m_VAO;
+	unsigned int GeometryBuffer::m_VBO;
+	unsigned int GeometryBuffer::m_EBO;
+	GeometryBuffer::Arena GeometryBuffer::m_vertices;
+	GeometryBuffer::Arena GeometryBuffer::m_indices;
+	VertexFormats::ID GeometryBuffer::m_format;
+	std::vector<PackedVertex> GeometryBuffer::m_packed;
+	std::vector<std::uint16_t> GeometryBuffer::m_shortIndices;
+
+	namespace
+	{
+		//Both index types share one buffer, the arena hands out 4 byte slots
+		const std::size_t INDEX_SLOT_SIZE = sizeof(unsigned int);
+
+		//Meshes are ranges inside these two buffers, so this is where their memory shows up
+		const char* const VERTEX_OWNER = "GeometryBuffer vertices";
+		const char* const INDEX_OWNER = "GeometryBuffer indices";
+
+		std::int16_t ToSnorm16(float value)
+		{
+			return (std::int16_t)std::round(glm::clamp(value, -1.f, 1.f) * 32767.f);
+		}
+
+		std::uint16_t ToUnorm16(float value)
+		{
+			return (std::uint16_t)std::round(glm::clamp(value, 0.f, 1.f) * 65535.f);
+		}
+	}
+
+	void GeometryBuffer::Init(VertexFormats::ID format, unsigned int vertexCapacity, unsigned int indexCapacity)
+	{
+		m_format = format;
+		m_vertices.Reset(vertexCapacity);
+		m_indices.Reset(indexCapacity);
+
+		glGenBuffers(1, &m_VBO);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_VBO);
+		glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * GetVertexStride(), NULL, GL_STATIC_DRAW);
+		GpuMemory::Register(GpuResources::Buffer, m_VBO, vertexCapacity * GetVertexStride(), VERTEX_OWNER);
+
+		glGenBuffers(1, &m_EBO);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_EBO);
+		glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * INDEX_SLOT_SIZE, NULL, GL_STATIC_DRAW);
+		GpuMemory::Register(GpuResources::Buffer, m_EBO, indexCapacity * INDEX_SLOT_SIZE, INDEX_OWNER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		glGenVertexArrays(1, &m_VAO);
+		SetupVertexArray();
+	}
+
+	void GeometryBuffer::Release()
+	{
+		GpuMemory::Unregister(GpuResources::Buffer, m_VBO);
+		GpuMemory::Unregister(GpuResources::Buffer, m_EBO);
+		glDeleteVertexArrays(1, &m_VAO);
+		glDeleteBuffers(1, &m_VBO);
+		glDeleteBuffers(1, &m_EBO);
+		m_VAO = m_VBO = m_EBO = 0;
+	}
+
+	GeometryRange GeometryBuffer::Allocate(const Vertex* vertices, unsigned int vertexCount, const unsigned int* const* indices, const unsigned int* indexCounts,
+										   unsigned int lodCount, const BoundingBox & bounds)
+	{
+		assert(lodCount > 0 && lodCount <= MAX_MESH_LODS);
+
+		GeometryRange range;
+		range.vertexCount = vertexCount;
+		range.lodCount = lodCount;
+
+		//Indices stay local to the mesh, baseVertex offsets them at draw time so 16 bits are enough for small meshes
+		range.indexType = (vertexCount < 65536) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		std::size_t indexSize = (range.indexType == GL_UNSIGNED_SHORT) ? sizeof(std::uint16_t) : sizeof(unsigned int);
+
+		//Every LOD starts on a slot boundary so its first index is a whole number of elements
+		unsigned int slotCount = 0;
+		for (unsigned int lod = 0; lod < lodCount; lod++)
+			slotCount += GetIndexSlots(indexCounts[lod], range.indexType);
+
+		range.baseVertex = Reserve(m_vertices, m_VBO, GetVertexStride(), vertexCount);
+		unsigned int slot = Reserve(m_indices, m_EBO, INDEX_SLOT_SIZE, slotCount);
+
+		const void* vertexData = vertices;
+		if (m_format == VertexFormats::Packed)
+		{
+			PackVertices(vertices, vertexCount, bounds);
+			vertexData = m_packed.data();
+		}
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_VBO);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, range.baseVertex * GetVertexStride(), vertexCount * GetVertexStride(), vertexData);
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_EBO);
+		for (unsigned int lod = 0; lod < lodCount; lod++)
+		{
+			range.firstIndex[lod] = (unsigned int)(slot * INDEX_SLOT_SIZE / indexSize);
+			range.indexCount[lod] = indexCounts[lod];
+
+			const void* indexData = indices[lod];
+			if (range.indexType == GL_UNSIGNED_SHORT)
+			{
+				m_shortIndices.assign(indices[lod], indices[lod] + indexCounts[lod]);
+				indexData = m_shortIndices.data();
+			}
+
+			glBufferSubData(GL_COPY_WRITE_BUFFER, slot * INDEX_SLOT_SIZE, indexCounts[lod] * indexSize, indexData);
+			slot += GetIndexSlots(indexCounts[lod], range.indexType);
+		}
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		return range;
+	}
+
+	void GeometryBuffer::Free(GeometryRange & range)
+	{
+		if (range.lodCount > 0)
+		{
+			std::size_t indexSize = (range.indexType == GL_UNSIGNED_SHORT) ? sizeof(std::uint16_t) : sizeof(unsigned int);
+			unsigned int firstSlot = (unsigned int)(range.firstIndex[0] * indexSize / INDEX_SLOT_SIZE);
+			unsigned int slotCount = 0;
+
+			for (unsigned int lod = 0; lod < range.lodCount; lod++)
+				slotCount += GetIndexSlots(range.indexCount[lod], range.indexType);
+
+			if (slotCount > 0)
+				m_indices.Free(firstSlot, slotCount);
+		}
+
+		if (range.vertexCount > 0)
+			m_vertices.Free(range.baseVertex, range.vertexCount);
+
+		range = GeometryRange();
+	}
+
+	glm::mat4 GeometryBuffer::GetDequantization(const BoundingBox & bounds)
+	{
+		if (m_format != VertexFormats::Packed || !bounds.IsValid())
+			return glm::mat4(1.f);
+
+		return glm::scale(glm::translate(glm::mat4(1.f), bounds.min), bounds.GetExtent());
+	}
+
+	VertexFormats::ID GeometryBuffer::GetVertexFormat()
+	{
+		return m_format;
+	}
+
+	std::size_t GeometryBuffer::GetVertexStride()
+	{
+		return (m_format == VertexFormats::Packed) ? sizeof(PackedVertex) : sizeof(Vertex);
+	}
+
+	void GeometryBuffer::Bind()
+	{
+		glBindVertexArray(m_VAO);
+	}
+
+	void GeometryBuffer::BindInstances(unsigned int buffer, std::size_t offset)
+	{
+		glBindVertexBuffer(VertexBindings::Instances, buffer, (GLintptr)offset, sizeof(InstanceData));
+	}
+
+	unsigned int GeometryBuffer::GetVertexCapacity()
+	{
+		return m_vertices.capacity;
+	}
+
+	unsigned int GeometryBuffer::GetIndexCapacity()
+	{
+		return m_indices.capacity;
+	}
+
+	unsigned int GeometryBuffer::GetUsedVertices()
+	{
+		return m_vertices.used;
+	}
+
+	unsigned int GeometryBuffer::GetUsedIndices()
+	{
+		return m_indices.used;
+	}
+
+	std::size_t GeometryBuffer::GetAllocationSize(const GeometryRange & range)
+	{
+		std::size_t bytes = range.vertexCount * GetVertexStride();
+		for (unsigned int lod = 0; lod < range.lodCount; lod++)
+			bytes += GetIndexSlots(range.indexCount[lod], range.indexType) * INDEX_SLOT_SIZE;
+
+		return bytes;
+	}
+
+	void GeometryBuffer::SetupVertexArray()
+	{
+		glBindVertexArray(m_VAO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+
+		//Positions and normals, the packed ones are decoded in the vertex shader
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+
+		if (m_format == VertexFormats::Packed)
+		{
+			glVertexAttribFormat(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(PackedVertex, position));
+			glVertexAttribFormat(1, 2, GL_SHORT, GL_TRUE, offsetof(PackedVertex, normal));
+		}
+		else
+		{
+			glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
+			glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normal));
+		}
+
+		glVertexAttribBinding(0, VertexBindings::Vertices);
+		glVertexAttribBinding(1, VertexBindings::Vertices);
+		glBindVertexBuffer(VertexBindings::Vertices, m_VBO, 0, (GLsizei)GetVertexStride());
+
+		//World matrix, one column per attribute location. The instance buffer is bound at draw time
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			glEnableVertexAttribArray(2 + i);
+			glVertexAttribFormat(2 + i, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, world) + i * sizeof(glm::vec4));
+			glVertexAttribBinding(2 + i, VertexBindings::Instances);
+		}
+
+		//Normal matrix
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			glEnableVertexAttribArray(6 + i);
+			glVertexAttribFormat(6 + i, 3, GL_FLOAT, GL_FALSE, offsetof(InstanceData, normal) + i * sizeof(glm::vec3));
+			glVertexAttribBinding(6 + i, VertexBindings::Instances);
+		}
+
+		//Color
+		glEnableVertexAttribArray(9);
+		glVertexAttribFormat(9, 3, GL_FLOAT, GL_FALSE, offsetof(InstanceData, color));
+		glVertexAttribBinding(9, VertexBindings::Instances);
+
+		glVertexBindingDivisor(VertexBindings::Instances, 1);
+
+		glBindVertexArray(0);
+	}
+
+	void GeometryBuffer::GrowBuffer(unsigned int & buffer, std::size_t usedBytes, std::size_t newBytes)
+	{
+		//Copy the old contents on the GPU and swap the handle
+		unsigned int grown;
+		glGenBuffers(1, &grown);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+		glBufferData(GL_COPY_WRITE_BUFFER, newBytes, NULL, GL_STATIC_DRAW);
+		GpuMemory::Register(GpuResources::Buffer, grown, newBytes, buffer == m_VBO ? VERTEX_OWNER : INDEX_OWNER);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		GpuMemory::Unregister(GpuResources::Buffer, buffer);
+		glDeleteBuffers(1, &buffer);
+		buffer = grown;
+	}
+
+	void GeometryBuffer::PackVertices(const Vertex * vertices, unsigned int count, const BoundingBox & bounds)
+	{
+		glm::vec3 extent = bounds.GetExtent();
+		glm::vec3 inverseExtent;
+		for (unsigned int axis = 0; axis < 3; axis++)
+			inverseExtent[axis] = extent[axis] > 0.f ? 1.f / extent[axis] : 0.f;
+
+		m_packed.resize(count);
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			PackedVertex & packed = m_packed[i];
+			glm::vec3 position = (vertices[i].position - bounds.min) * inverseExtent;
+
+			for (unsigned int axis = 0; axis < 3; axis++)
+				packed.position[axis] = ToUnorm16(position[axis]);
+			packed.padding = 0;
+
+			//Octahedral mapping: project onto the octahedron and fold the lower half over the diagonals
+			glm::vec3 normal = vertices[i].normal;
+			float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			glm::vec2 octahedral = length > 0.f ? glm::vec2(normal.x, normal.y) / length : glm::vec2(0.f);
+
+			if (normal.z < 0.f)
+			{
+				glm::vec2 sign(octahedral.x >= 0.f ? 1.f : -1.f, octahedral.y >= 0.f ? 1.f : -1.f);
+				octahedral = (1.f - glm::abs(glm::vec2(octahedral.y, octahedral.x))) * sign;
+			}
+
+			packed.normal[0] = ToSnorm16(octahedral.x);
+			packed.normal[1] = ToSnorm16(octahedral.y);
+		}
+	}
+
+	unsigned int GeometryBuffer::GetIndexSlots(unsigned int indexCount, GLenum indexType)
+	{
+		std::size_t indexSize = (indexType == GL_UNSIGNED_SHORT) ? sizeof(std::uint16_t) : sizeof(unsigned int);
+		return (unsigned int)((indexCount * indexSize + INDEX_SLOT_SIZE - 1) / INDEX_SLOT_SIZE);
+	}
+
+	unsigned int GeometryBuffer::Reserve(Arena & arena, unsigned int & buffer, std::size_t stride, unsigned int count)
+	{
+		unsigned int offset = 0;
+		if (arena.Allocate(count, offset))
+			return offset;
+
+		unsigned int capacity = std::max(arena.capacity * 2, arena.capacity + count);
+		GrowBuffer(buffer, arena.capacity * stride, capacity * stride);
+		arena.Extend(capacity);
+		SetupVertexArray();
+
+		bool allocated = arena.Allocate(count, offset);
+		assert(allocated);
+		(void)allocated;
+
+		return offset;
+	}
+
+	void GeometryBuffer::Arena::Reset(unsigned int newCapacity)
+	{
+		capacity = newCapacity;
+		used = 0;
+		m_free.clear();
+		m_free.push_back({ 0, newCapacity });
+	}
+
+	bool GeometryBuffer::Arena::Allocate(unsigned int count, unsigned int & offset)
+	{
+		for (auto it = m_free.begin(); it != m_free.end(); ++it)
+		{
+			if (it->count < count)
+				continue;
+
+			offset = it->offset;
+			it->offset += count;
+			it->count -= count;
+
+			if (it->count == 0)
+				m_free.erase(it);
+
+			used += count;
+			return true;
+		}
+
+		return false;
+	}
+
+	void GeometryBuffer::Arena::Free(unsigned int offset, unsigned int count)
+	{
+		used -= count;
+		Insert(offset, count);
+	}
+
+	void GeometryBuffer::Arena::Extend(unsigned int newCapacity)
+	{
+		//The new tail joins the free list like a released block
+		Insert(capacity, newCapacity - capacity);
+		capacity = newCapacity;
+	}
+
+	void GeometryBuffer::Arena::Insert(unsigned int offset, unsigned int count)
+	{
+		//The list is kept sorted by offset so merging only has to look at the neighbours
+		auto next = std::lower_bound(m_free.begin(), m_free.end(), offset, [](const Block & block, unsigned int value) { return block.offset < value; });
+		auto it = m_free.insert(next, { offset, count });
+
+		auto following = it + 1;
+		if (following != m_free.end() && it->offset + it->count == following->offset)
+		{
+			it->count += following->count;
+			it = m_free.erase(following) - 1;
+		}
+
+		if (it != m_free.begin())
+		{
+			auto previous = it - 1;
+			if (previous->offset + previous->count == it->offset)
+			{
+				previous->count += it->count;
+				m_free.erase(it);
+			}
+		}
+	}
+}
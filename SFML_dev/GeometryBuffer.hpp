@@ -0,0 +1,155 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "Bounds.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace px
+{
+	struct Vertex
+	{
+		//Only position and normal at this point
+		glm::vec3 position;
+		glm::vec3 normal;
+	};
+
+	//12 byte GPU layout, positions are unorm16 inside the mesh bounds and normals are octahedral snorm16
+	struct PackedVertex
+	{
+		std::uint16_t position[3];
+		std::uint16_t padding;
+		std::int16_t normal[2];
+	};
+
+	static_assert(sizeof(PackedVertex) == 12, "Packed vertex layout changed");
+
+	namespace VertexFormats
+	{
+		enum ID
+		{
+			Full,
+			Packed
+		};
+	}
+
+	//Per-instance attributes, streamed once per frame by the render system
+	struct InstanceData
+	{
+		glm::mat4 world;
+		glm::mat3 normal;
+		glm::vec3 color;
+	};
+
+	//Vertex buffer binding points of the shared geometry VAO
+	namespace VertexBindings
+	{
+		enum ID
+		{
+			Vertices,
+			Instances
+		};
+	}
+
+	//Layout read by glMultiDrawElementsIndirect
+	struct DrawElementsIndirectCommand
+	{
+		unsigned int count;
+		unsigned int instanceCount;
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int baseInstance;
+	};
+
+	//Full detail plus up to three simplified index lists sharing the same vertices
+	const unsigned int MAX_MESH_LODS = 4;
+
+	//Where a mesh lives inside the shared arenas, firstIndex is counted in elements of indexType
+	struct GeometryRange
+	{
+		GeometryRange() : baseVertex(0), vertexCount(0), firstIndex(), indexCount(), lodCount(0), indexType(GL_UNSIGNED_INT) {}
+
+		unsigned int baseVertex;
+		unsigned int vertexCount;
+		unsigned int firstIndex[MAX_MESH_LODS];
+		unsigned int indexCount[MAX_MESH_LODS];
+		unsigned int lodCount;
+		GLenum indexType;
+	};
+
+	//All static mesh data is sub-allocated from one vertex and one index buffer behind a single VAO
+	class GeometryBuffer
+	{
+	public:
+		static void Init(VertexFormats::ID format = VertexFormats::Packed, unsigned int vertexCapacity = 1 << 16, unsigned int indexCapacity = 1 << 18);
+		static void Release();
+
+	public:
+		//indices and indexCounts hold one entry per LOD, all of them land in one contiguous index block
+		static GeometryRange Allocate(const Vertex* vertices, unsigned int vertexCount, const unsigned int* const* indices, const unsigned int* indexCounts,
+									  unsigned int lodCount, const BoundingBox & bounds);
+		static void Free(GeometryRange & range);
+
+	public:
+		static void Bind();
+		static void BindInstances(unsigned int buffer, std::size_t offset);
+
+	public:
+		//Maps packed positions back into mesh space, folded into the instance world matrix
+		static glm::mat4 GetDequantization(const BoundingBox & bounds);
+
+	public:
+		static VertexFormats::ID GetVertexFormat();
+		static std::size_t GetVertexStride();
+		static unsigned int GetVertexCapacity();
+		static unsigned int GetIndexCapacity();
+		static unsigned int GetUsedVertices();
+		static std::size_t GetAllocationSize(const GeometryRange & range);
+
+		//Index usage is counted in 4 byte slots since 16 and 32 bit indices share the buffer
+		static unsigned int GetUsedIndices();
+
+	private:
+		//First-fit free list over element slots, neighbouring blocks are merged on release
+		class Arena
+		{
+		public:
+			void Reset(unsigned int capacity);
+			bool Allocate(unsigned int count, unsigned int & offset);
+			void Free(unsigned int offset, unsigned int count);
+			void Extend(unsigned int capacity);
+
+		private:
+			void Insert(unsigned int offset, unsigned int count);
+
+		public:
+			unsigned int capacity = 0;
+			unsigned int used = 0;
+
+		private:
+			struct Block
+			{
+				unsigned int offset;
+				unsigned int count;
+			};
+
+			std::vector<Block> m_free;
+		};
+
+	private:
+		static void SetupVertexArray();
+		static void PackVertices(const Vertex* vertices, unsigned int count, const BoundingBox & bounds);
+		static unsigned int GetIndexSlots(unsigned int indexCount, GLenum indexType);
+		static void GrowBuffer(unsigned int & buffer, std::size_t usedBytes, std::size_t newBytes);
+		static unsigned int Reserve(Arena & arena, unsigned int & buffer, std::size_t stride, unsigned int count);
+
+	private:
+		static unsigned int m_VAO, m_VBO, m_EBO;
+		static Arena m_vertices;
+		static Arena m_indices;
+		static VertexFormats::ID m_format;
+		static std::vector<PackedVertex> m_packed;
+		static std::vector<std::uint16_t> m_shortIndices;
+	};
+}
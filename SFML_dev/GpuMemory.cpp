@@ -0,0 +1,143 @@
+#include "GpuMemory.hpp"
+#include <algorithm>
+
+namespace px
+{
+	GpuMemory::Allocations GpuMemory::m_allocations;
+	std::size_t GpuMemory::m_bytes[GpuResources::Count];
+	unsigned int GpuMemory::m_counts[GpuResources::Count];
+	std::uint64_t GpuMemory::m_frame = 0;
+
+	void GpuMemory::Register(GpuResources::ID type, unsigned int handle, std::size_t bytes, const std::string & owner)
+	{
+		//Handles get reused by the driver, a stale entry for the same one is replaced
+		Unregister(type, handle);
+
+		GpuAllocation allocation;
+		allocation.type = type;
+		allocation.handle = handle;
+		allocation.bytes = bytes;
+		allocation.owner = owner;
+		allocation.frame = m_frame;
+
+		m_allocations[Key(type, handle)] = allocation;
+		m_bytes[type] += bytes;
+		m_counts[type]++;
+	}
+
+	void GpuMemory::Resize(GpuResources::ID type, unsigned int handle, std::size_t bytes)
+	{
+		auto found = m_allocations.find(Key(type, handle));
+		if (found == m_allocations.end())
+			return;
+
+		m_bytes[type] = m_bytes[type] - found->second.bytes + bytes;
+		found->second.bytes = bytes;
+		found->second.frame = m_frame;
+	}
+
+	void GpuMemory::Unregister(GpuResources::ID type, unsigned int handle)
+	{
+		auto found = m_allocations.find(Key(type, handle));
+		if (found == m_allocations.end())
+			return;
+
+		m_bytes[type] -= found->second.bytes;
+		m_counts[type]--;
+		m_allocations.erase(found);
+	}
+
+	void GpuMemory::NextFrame()
+	{
+		m_frame++;
+	}
+
+	const GpuMemory::Allocations & GpuMemory::GetAllocations()
+	{
+		return m_allocations;
+	}
+
+	std::size_t GpuMemory::GetTotalBytes()
+	{
+		std::size_t bytes = 0;
+		for (unsigned int type = 0; type < GpuResources::Count; type++)
+			bytes += m_bytes[type];
+
+		return bytes;
+	}
+
+	std::size_t GpuMemory::GetBytes(GpuResources::ID type)
+	{
+		return m_bytes[type];
+	}
+
+	unsigned int GpuMemory::GetCount(GpuResources::ID type)
+	{
+		return m_counts[type];
+	}
+
+	std::uint64_t GpuMemory::GetFrame()
+	{
+		return m_frame;
+	}
+
+	const char* GpuMemory::GetTypeName(GpuResources::ID type)
+	{
+		switch (type)
+		{
+		case GpuResources::Buffer: return "Buffer";
+		case GpuResources::Texture: return "Texture";
+		case GpuResources::Renderbuffer: return "Renderbuffer";
+		case GpuResources::Framebuffer: return "Framebuffer";
+		default: return "Unknown";
+		}
+	}
+
+	std::size_t GpuMemory::GetTextureBytes(GLenum internalFormat, unsigned int width, unsigned int height, unsigned int levels, unsigned int layers, unsigned int samples)
+	{
+		//Block formats store 4x4 texels per block, everything else is counted per texel. RGB is padded to four bytes by every driver we know of
+		std::size_t blockBytes = 0, texelBytes = 4;
+		switch (internalFormat)
+		{
+		case 0x83F0: //COMPRESSED_RGB_S3TC_DXT1
+		case 0x83F1: //COMPRESSED_RGBA_S3TC_DXT1
+		case GL_COMPRESSED_RED_RGTC1:
+			blockBytes = 8;
+			break;
+		case 0x83F2: //COMPRESSED_RGBA_S3TC_DXT3
+		case 0x83F3: //COMPRESSED_RGBA_S3TC_DXT5
+		case GL_COMPRESSED_RG_RGTC2:
+			blockBytes = 16;
+			break;
+		case GL_R8:
+			texelBytes = 1;
+			break;
+		case GL_RG8:
+		case GL_R16F:
+		case GL_DEPTH_COMPONENT16:
+			texelBytes = 2;
+			break;
+		case GL_RGBA16F:
+		case GL_RG32F:
+			texelBytes = 8;
+			break;
+		case GL_RGBA32F:
+			texelBytes = 16;
+			break;
+		default:
+			break;
+		}
+
+		std::size_t bytes = 0;
+		for (unsigned int level = 0; level < levels; level++)
+		{
+			std::size_t levelWidth = std::max(width >> level, 1u), levelHeight = std::max(height >> level, 1u);
+			if (blockBytes > 0)
+				bytes += ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockBytes;
+			else
+				bytes += levelWidth * levelHeight * texelBytes;
+		}
+
+		return bytes * layers * samples;
+	}
+}
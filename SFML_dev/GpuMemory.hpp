@@ -0,0 +1,67 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace px
+{
+	namespace GpuResources
+	{
+		enum ID
+		{
+			Buffer,
+			Texture,
+			Renderbuffer,
+			Framebuffer,
+			Count
+		};
+	}
+
+	//One live GL object, sizes are what the object was allocated with, not what the driver reports
+	struct GpuAllocation
+	{
+		GpuResources::ID type;
+		unsigned int handle;
+		std::size_t bytes;
+		std::string owner;
+		std::uint64_t frame;
+	};
+
+	//Every buffer, texture, renderbuffer and framebuffer is registered here by whoever creates it, so VRAM use
+	//can be broken down by owner. GL objects are only created on the context thread, so nothing is locked
+	class GpuMemory
+	{
+	public:
+		typedef std::pair<GpuResources::ID, unsigned int> Key;
+		typedef std::map<Key, GpuAllocation> Allocations;
+
+	public:
+		static void Register(GpuResources::ID type, unsigned int handle, std::size_t bytes, const std::string & owner);
+		static void Resize(GpuResources::ID type, unsigned int handle, std::size_t bytes);
+		static void Unregister(GpuResources::ID type, unsigned int handle);
+		static void NextFrame();
+
+	public:
+		static const Allocations & GetAllocations();
+		static std::size_t GetTotalBytes();
+		static std::size_t GetBytes(GpuResources::ID type);
+		static unsigned int GetCount(GpuResources::ID type);
+		static std::uint64_t GetFrame();
+		static const char* GetTypeName(GpuResources::ID type);
+
+	public:
+		//Estimated storage of a texture, every level halves down to 1x1 and layers are multiplied in
+		static std::size_t GetTextureBytes(GLenum internalFormat, unsigned int width, unsigned int height, unsigned int levels = 1,
+										   unsigned int layers = 1, unsigned int samples = 1);
+
+	private:
+		static Allocations m_allocations;
+		static std::size_t m_bytes[GpuResources::Count];
+		static unsigned int m_counts[GpuResources::Count];
+		static std::uint64_t m_frame;
+	};
+}
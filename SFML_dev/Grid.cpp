@@ -1,17 +1,19 @@
 #include "Grid.hpp"
+#include "GpuMemory.hpp"
 #include <glad/glad.h>
-#include "Camera.hpp"
 #include <iostream>
 
 namespace px
 {
-	Grid::Grid(std::shared_ptr<Camera> & camera) : m_camera(camera)
+	Grid::Grid()
 	{
 		SetupGrid();
 	}
 
 	Grid::~Grid()
 	{
+		GpuMemory::Unregister(GpuResources::Buffer, m_VBO);
+		GpuMemory::Unregister(GpuResources::Buffer, m_EBO);
 		glDeleteVertexArrays(1, &m_VAO);
 		glDeleteBuffers(1, &m_VBO);
 		glDeleteBuffers(1, &m_EBO);
@@ -24,9 +26,8 @@ namespace px
 		glm::mat4 m_world = glm::mat4();
 		m_world = glm::translate(m_world, glm::vec3(-50.f, 0.f, -50.f));
 
+		//Projection and view come from the frame constants
 		Shader::SetMatrix4x4(id, "model", m_world);
-		Shader::SetMatrix4x4(id, "projection", m_camera->GetProjectionMatrix());
-		Shader::SetMatrix4x4(id, "view", m_camera->GetViewMatrix());
 
 		glBindVertexArray(m_VAO);
 		glDrawElements(GL_LINES, m_indexCount, GL_UNSIGNED_INT, 0);
@@ -125,9 +126,11 @@ namespace px
 		glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
 		glBufferData(GL_ARRAY_BUFFER, m_vertexCount * sizeof(glm::vec3), vertices, GL_STATIC_DRAW);
+		GpuMemory::Register(GpuResources::Buffer, m_VBO, m_vertexCount * sizeof(glm::vec3), "Grid vertices");
 
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+		GpuMemory::Register(GpuResources::Buffer, m_EBO, m_indexCount * sizeof(unsigned int), "Grid indices");
 
 		//Positions
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
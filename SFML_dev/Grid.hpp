@@ -10,12 +10,10 @@
 
 namespace px
 {
-	class Camera;
-
 	class Grid
 	{
 	public:
-		Grid(std::shared_ptr<Camera> & camera);
+		Grid();
 		~Grid();
 
 	public:
@@ -25,7 +23,6 @@ namespace px
 		void SetupGrid();
 
 	private:
-		std::shared_ptr<Camera> m_camera;
 		unsigned int m_VAO, m_VBO, m_EBO;
 		unsigned int m_width, m_height;
 		unsigned int m_vertexCount, m_indexCount;
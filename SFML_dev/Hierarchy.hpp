@@ -0,0 +1,18 @@
+#pragma once
+#include <entityx\entityx.h>
+
+namespace px
+{
+	//Parent and child links between entities, the children of an entity form a list through the sibling links.
+	//Only the scene edits these, the matching transform parents are kept in its TransformStore
+	struct Hierarchy
+	{
+		Hierarchy() : parent(entityx::Entity::INVALID), firstChild(entityx::Entity::INVALID), previousSibling(entityx::Entity::INVALID),
+					  nextSibling(entityx::Entity::INVALID) {}
+
+		entityx::Entity::Id parent;
+		entityx::Entity::Id firstChild;
+		entityx::Entity::Id previousSibling;
+		entityx::Entity::Id nextSibling;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "JobSystem.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace px
+{
+	std::vector<std::unique_ptr<JobSystem::Worker>> JobSystem::m_workers;
+	std::vector<std::thread> JobSystem::m_threads;
+	std::deque<JobSystem::Job> JobSystem::m_mainJobs;
+	std::mutex JobSystem::m_mainMutex;
+	std::mutex JobSystem::m_sleepMutex;
+	std::condition_variable JobSystem::m_condition;
+	std::atomic<int> JobSystem::m_pending(0);
+	std::atomic<int> JobSystem::m_sleeping(0);
+	std::atomic<bool> JobSystem::m_stopping(false);
+	std::vector<JobStatistics> JobSystem::m_statistics;
+	JobSystem::Clock::time_point JobSystem::m_frameStart;
+
+	namespace
+	{
+		const unsigned int NO_THREAD = 0xffffffff;
+
+		//Index into the worker list, threads the job system didn't start have none
+		thread_local unsigned int t_threadIndex = NO_THREAD;
+
+		//Jobs run from inside a waiting job are already covered by the outer job's busy time
+		thread_local unsigned int t_depth = 0;
+	}
+
+	void JobSystem::Init(unsigned int workerCount)
+	{
+		if (workerCount == 0)
+			workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		m_stopping = false;
+		for (unsigned int i = 0; i <= workerCount; i++)
+		{
+			std::unique_ptr<Worker> worker = std::make_unique<Worker>();
+			worker->busyTime = 0;
+			worker->jobCount = 0;
+			worker->steals = 0;
+			m_workers.push_back(std::move(worker));
+		}
+
+		m_statistics.assign(workerCount + 1, JobStatistics());
+		m_frameStart = Clock::now();
+
+		t_threadIndex = 0;
+		for (unsigned int i = 1; i <= workerCount; i++)
+			m_threads.emplace_back(&JobSystem::WorkerLoop, i);
+	}
+
+	void JobSystem::Release()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_stopping = true;
+		}
+		m_condition.notify_all();
+
+		for (std::thread & thread : m_threads)
+			thread.join();
+
+		m_threads.clear();
+		m_workers.clear();
+		m_mainJobs.clear();
+		m_statistics.clear();
+		m_pending = 0;
+		t_threadIndex = NO_THREAD;
+	}
+
+	void JobSystem::NextFrame()
+	{
+		Clock::time_point now = Clock::now();
+		double frameTime = std::chrono::duration<double, std::milli>(now - m_frameStart).count();
+		m_frameStart = now;
+
+		for (unsigned int i = 0; i < m_workers.size(); i++)
+		{
+			Worker & worker = *m_workers[i];
+			JobStatistics & statistics = m_statistics[i];
+			statistics.busyTime = (double)worker.busyTime.exchange(0) / 1000000.0;
+			statistics.utilization = frameTime > 0.0 ? (float)std::min(statistics.busyTime / frameTime, 1.0) : 0.f;
+			statistics.jobs = worker.jobCount.exchange(0);
+			statistics.steals = worker.steals.exchange(0);
+		}
+	}
+
+	void JobSystem::Run(std::function<void()> job, JobCounter * counter, JobThreads::ID thread)
+	{
+		if (m_workers.empty())
+		{
+			job();
+			return;
+		}
+
+		if (counter)
+			counter->m_count++;
+
+		Job entry;
+		entry.work = std::move(job);
+		entry.counter = counter;
+
+		if (thread == JobThreads::Main)
+		{
+			std::lock_guard<std::mutex> lock(m_mainMutex);
+			m_mainJobs.push_back(std::move(entry));
+		}
+		else
+			Push(std::move(entry));
+	}
+
+	void JobSystem::ParallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t, std::size_t)> & body)
+	{
+		grainSize = std::max(grainSize, (std::size_t)1);
+		if (m_workers.empty() || count <= grainSize)
+		{
+			if (count > 0)
+				body(0, count);
+			return;
+		}
+
+		//The caller keeps the first range for itself, the rest is up for grabs
+		JobCounter counter;
+		for (std::size_t begin = grainSize; begin < count; begin += grainSize)
+		{
+			std::size_t end = std::min(begin + grainSize, count);
+			Run([&body, begin, end] { body(begin, end); }, &counter);
+		}
+
+		body(0, grainSize);
+		Wait(counter);
+	}
+
+	void JobSystem::Wait(JobCounter & counter)
+	{
+		unsigned int index = t_threadIndex;
+		while (!counter.IsDone())
+		{
+			if (index == 0 && TryRunMainJob())
+				continue;
+			if (index != NO_THREAD && TryRunJob(index))
+				continue;
+
+			std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::RunMainJobs()
+	{
+		while (TryRunMainJob());
+	}
+
+	unsigned int JobSystem::GetThreadCount()
+	{
+		return (unsigned int)m_workers.size();
+	}
+
+	const std::vector<JobStatistics> & JobSystem::GetStatistics()
+	{
+		return m_statistics;
+	}
+
+	std::vector<JobBenchmark> JobSystem::RunBenchmarks()
+	{
+		std::vector<JobBenchmark> results;
+		auto elapsed = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+		//Scheduling overhead, jobs that do nothing
+		{
+			const unsigned int JOBS = 100000;
+			std::atomic<unsigned int> sink(0);
+			std::function<void()> job = [&sink] { sink.fetch_add(1, std::memory_order_relaxed); };
+
+			JobBenchmark result;
+			result.name = "Empty jobs";
+			result.jobs = JOBS;
+
+			Clock::time_point start = Clock::now();
+			for (unsigned int i = 0; i < JOBS; i++)
+				job();
+			result.serialTime = elapsed(start);
+
+			JobCounter counter;
+			start = Clock::now();
+			for (unsigned int i = 0; i < JOBS; i++)
+				Run(job, &counter);
+			Wait(counter);
+			result.parallelTime = elapsed(start);
+			results.push_back(result);
+		}
+
+		//Arithmetic over a large array split into ranges
+		{
+			const std::size_t COUNT = 1 << 22, GRAIN = 1 << 14;
+			std::vector<float> values(COUNT);
+			auto body = [&values](std::size_t begin, std::size_t end)
+			{
+				for (std::size_t i = begin; i < end; i++)
+					values[i] = std::sqrt((float)i) * std::sin((float)i);
+			};
+
+			JobBenchmark result;
+			result.name = "Parallel for";
+			result.jobs = (unsigned int)(COUNT / GRAIN);
+
+			Clock::time_point start = Clock::now();
+			body(0, COUNT);
+			result.serialTime = elapsed(start);
+
+			start = Clock::now();
+			ParallelFor(COUNT, GRAIN, body);
+			result.parallelTime = elapsed(start);
+			results.push_back(result);
+		}
+
+		//Jobs that wait on parallel loops of their own, only finishes quickly if waiting threads keep stealing
+		{
+			const std::size_t OUTER = 64, INNER = 1 << 16, GRAIN = 1 << 12;
+			std::vector<float> values(OUTER * INNER);
+			auto body = [&values](std::size_t offset, std::size_t begin, std::size_t end)
+			{
+				for (std::size_t i = begin; i < end; i++)
+					values[offset + i] = std::sqrt((float)i) * std::cos((float)(offset + i));
+			};
+
+			JobBenchmark result;
+			result.name = "Nested parallel for";
+			result.jobs = (unsigned int)(OUTER * (INNER / GRAIN + 1));
+
+			Clock::time_point start = Clock::now();
+			for (std::size_t outer = 0; outer < OUTER; outer++)
+				body(outer * INNER, 0, INNER);
+			result.serialTime = elapsed(start);
+
+			JobCounter counter;
+			start = Clock::now();
+			for (std::size_t outer = 0; outer < OUTER; outer++)
+			{
+				Run([&body, outer]
+				{
+					ParallelFor(INNER, GRAIN, [&body, outer](std::size_t begin, std::size_t end) { body(outer * INNER, begin, end); });
+				}, &counter);
+			}
+			Wait(counter);
+			result.parallelTime = elapsed(start);
+			results.push_back(result);
+		}
+
+		//Workers handing results back to the main thread, the round trip a GL upload takes
+		{
+			const unsigned int JOBS = 1000;
+			std::atomic<unsigned int> sink(0);
+
+			JobBenchmark result;
+			result.name = "Main thread jobs";
+			result.jobs = JOBS * 2;
+
+			Clock::time_point start = Clock::now();
+			for (unsigned int i = 0; i < JOBS; i++)
+				sink++;
+			result.serialTime = elapsed(start);
+
+			JobCounter counter;
+			start = Clock::now();
+			for (unsigned int i = 0; i < JOBS; i++)
+				Run([&sink, &counter] { Run([&sink] { sink++; }, &counter, JobThreads::Main); }, &counter);
+			Wait(counter);
+			result.parallelTime = elapsed(start);
+			results.push_back(result);
+		}
+
+		return results;
+	}
+
+	void JobSystem::WorkerLoop(unsigned int index)
+	{
+		t_threadIndex = index;
+
+		while (!m_stopping)
+		{
+			if (TryRunJob(index))
+				continue;
+
+			//Pushers only take the lock when someone sleeps, the sleeper counts itself before it checks for work
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_sleeping++;
+			m_condition.wait(lock, [] { return m_pending > 0 || m_stopping; });
+			m_sleeping--;
+		}
+	}
+
+	void JobSystem::Push(Job job)
+	{
+		//Threads outside the job system hand their jobs to the main thread's deque, where they are stolen like any other
+		unsigned int index = t_threadIndex != NO_THREAD ? t_threadIndex : 0;
+		{
+			Worker & worker = *m_workers[index];
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			worker.jobs.push_back(std::move(job));
+		}
+
+		m_pending++;
+		if (m_sleeping > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_condition.notify_one();
+		}
+	}
+
+	bool JobSystem::TryRunJob(unsigned int index)
+	{
+		Job job;
+		bool found = false;
+
+		//Newest own job first, it is the most likely to still be in cache
+		{
+			Worker & worker = *m_workers[index];
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			if (!worker.jobs.empty())
+			{
+				job = std::move(worker.jobs.back());
+				worker.jobs.pop_back();
+				found = true;
+			}
+		}
+
+		//Then the oldest job of anyone else, those tend to be the biggest
+		unsigned int count = (unsigned int)m_workers.size();
+		for (unsigned int i = 1; i < count && !found; i++)
+		{
+			Worker & victim = *m_workers[(index + i) % count];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.jobs.empty())
+			{
+				job = std::move(victim.jobs.front());
+				victim.jobs.pop_front();
+				m_workers[index]->steals++;
+				found = true;
+			}
+		}
+
+		if (!found)
+			return false;
+
+		m_pending--;
+		Execute(job, index);
+		return true;
+	}
+
+	bool JobSystem::TryRunMainJob()
+	{
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(m_mainMutex);
+			if (m_mainJobs.empty())
+				return false;
+
+			job = std::move(m_mainJobs.front());
+			m_mainJobs.pop_front();
+		}
+
+		Execute(job, 0);
+		return true;
+	}
+
+	void JobSystem::Execute(Job & job, unsigned int index)
+	{
+		Clock::time_point start = Clock::now();
+
+		t_depth++;
+		job.work();
+		t_depth--;
+
+		Worker & worker = *m_workers[index];
+		if (t_depth == 0)
+			worker.busyTime += (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+		worker.jobCount++;
+
+		if (job.counter)
+			job.counter->m_count--;
+	}
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace px
+{
+	//Main jobs only run on the thread that called JobSystem::Init(), that is where everything touching the GL context goes
+	namespace JobThreads
+	{
+		enum ID
+		{
+			Any,
+			Main
+		};
+	}
+
+	//Counts the jobs started with it that haven't finished yet, has to outlive them
+	class JobCounter
+	{
+	public:
+		JobCounter();
+
+		JobCounter(const JobCounter &) = delete;
+		JobCounter & operator=(const JobCounter &) = delete;
+
+	public:
+		bool IsDone() const;
+
+	private:
+		friend class JobSystem;
+		std::atomic<unsigned int> m_count;
+	};
+
+	//What one thread did during the last frame, thread 0 is the main thread
+	struct JobStatistics
+	{
+		double busyTime;
+		float utilization;
+		unsigned int jobs;
+		unsigned int steals;
+	};
+
+	struct JobBenchmark
+	{
+		std::string name;
+		unsigned int jobs;
+		double serialTime;
+		double parallelTime;
+	};
+
+	//Work-stealing scheduler for short per-frame jobs. Every thread owns a deque, it pushes and pops its own jobs at
+	//the back while idle threads steal from the front of the others. Waiting threads run jobs instead of blocking.
+	//Long blocking work such as file loads stays on the ThreadPool so it never holds up a frame
+	class JobSystem
+	{
+	public:
+		//Zero workers picks one per hardware thread besides the calling one, which becomes the main thread
+		static void Init(unsigned int workerCount = 0);
+		static void Release();
+		static void NextFrame();
+
+	public:
+		//Without Init() jobs simply run on the calling thread
+		static void Run(std::function<void()> job, JobCounter* counter = nullptr, JobThreads::ID thread = JobThreads::Any);
+
+		//Splits [0, count) into ranges of at most grainSize and spreads them over every thread, the caller included.
+		//Returns once all ranges are done
+		static void ParallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t, std::size_t)> & body);
+
+		//Runs other jobs until the counter reaches zero, the main thread also runs main jobs
+		static void Wait(JobCounter & counter);
+		static void RunMainJobs();
+
+	public:
+		static unsigned int GetThreadCount();
+		static const std::vector<JobStatistics> & GetStatistics();
+
+		//Serial against parallel timings of a few typical workloads, has to be called from the main thread
+		static std::vector<JobBenchmark> RunBenchmarks();
+
+	private:
+		typedef std::chrono::high_resolution_clock Clock;
+
+		struct Job
+		{
+			std::function<void()> work;
+			JobCounter* counter;
+		};
+
+		struct Worker
+		{
+			std::deque<Job> jobs;
+			std::mutex mutex;
+			std::atomic<std::uint64_t> busyTime;
+			std::atomic<unsigned int> jobCount;
+			std::atomic<unsigned int> steals;
+		};
+
+	private:
+		static void WorkerLoop(unsigned int index);
+		static void Push(Job job);
+		static bool TryRunJob(unsigned int index);
+		static bool TryRunMainJob();
+		static void Execute(Job & job, unsigned int index);
+
+	private:
+		static std::vector<std::unique_ptr<Worker>> m_workers;
+		static std::vector<std::thread> m_threads;
+		static std::deque<Job> m_mainJobs;
+		static std::mutex m_mainMutex;
+		static std::mutex m_sleepMutex;
+		static std::condition_variable m_condition;
+		static std::atomic<int> m_pending;
+		static std::atomic<int> m_sleeping;
+		static std::atomic<bool> m_stopping;
+		static std::vector<JobStatistics> m_statistics;
+		static Clock::time_point m_frameStart;
+	};
+
+	inline JobCounter::JobCounter() : m_count(0)
+	{
+	}
+
+	inline bool JobCounter::IsDone() const
+	{
+		return m_count.load() == 0;
+	}
+}
@@ -0,0 +1,137 @@
+#include "MappedFile.hpp"
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace px
+{
+#ifdef _WIN32
+	MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+	{
+	}
+#else
+	MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_file(-1)
+	{
+	}
+#endif
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string & path)
+	{
+		Close();
+
+#ifdef _WIN32
+		m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (m_file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!m_mapping)
+		{
+			Close();
+			return false;
+		}
+
+		m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+		m_size = (std::size_t)size.QuadPart;
+#else
+		m_file = open(path.c_str(), O_RDONLY);
+		if (m_file < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(m_file, &info) != 0 || info.st_size == 0)
+		{
+			Close();
+			return false;
+		}
+
+		void* data = mmap(nullptr, (std::size_t)info.st_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+		m_data = (data == MAP_FAILED) ? nullptr : (const unsigned char*)data;
+		m_size = (std::size_t)info.st_size;
+#endif
+
+		if (!m_data)
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef _WIN32
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_mapping)
+			CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+#else
+		if (m_data)
+			munmap((void*)m_data, m_size);
+		if (m_file >= 0)
+			close(m_file);
+
+		m_file = -1;
+#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	const unsigned char* MappedFile::GetData() const
+	{
+		return m_data;
+	}
+
+	std::size_t MappedFile::GetSize() const
+	{
+		return m_size;
+	}
+
+	bool MappedFile::IsOpen() const
+	{
+		return m_data != nullptr;
+	}
+
+	bool MappedFile::GetStamp(const std::string & path, std::uint64_t & size, std::int64_t & time)
+	{
+#ifdef _WIN32
+		struct _stat64 info;
+		if (_stat64(path.c_str(), &info) != 0)
+			return false;
+#else
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0)
+			return false;
+#endif
+
+		size = (std::uint64_t)info.st_size;
+		time = (std::int64_t)info.st_mtime;
+		return true;
+	}
+}
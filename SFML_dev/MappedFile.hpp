@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace px
+{
+	//Read-only memory mapping of a whole file, unmapped on destruction
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile & operator=(const MappedFile &) = delete;
+
+	public:
+		bool Open(const std::string & path);
+		void Close();
+
+	public:
+		const unsigned char* GetData() const;
+		std::size_t GetSize() const;
+		bool IsOpen() const;
+
+	public:
+		//Size and modification time, cooked caches store these to notice a changed source
+		static bool GetStamp(const std::string & path, std::uint64_t & size, std::int64_t & time);
+
+	private:
+		const unsigned char* m_data;
+		std::size_t m_size;
+#ifdef _WIN32
+		void* m_file;
+		void* m_mapping;
+#else
+		int m_file;
+#endif
+	};
+}
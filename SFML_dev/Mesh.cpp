@@ -1,26 +1,28 @@
 #include "Mesh.hpp"
+#include <cmath>
 
 namespace px
 {
-	Mesh::Mesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, glm::vec3 & color) : m_vertices(vertices), m_indices(indices), m_color(color)
+	Mesh::Mesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, glm::vec3 & color, unsigned int material) : m_material(material), m_color(color)
 	{
-		SetupMesh();
+		ComputeBounds(vertices.data(), (unsigned int)vertices.size(), m_boundingBox, m_boundingSphere);
+		const unsigned int* indexData = indices.data();
+		unsigned int indexCount = (unsigned int)indices.size();
+
+		m_range = GeometryBuffer::Allocate(vertices.data(), (unsigned int)vertices.size(), &indexData, &indexCount, 1, m_boundingBox);
+		m_dequantization = GeometryBuffer::GetDequantization(m_boundingBox);
 	}
 
-	void Mesh::Draw(Shaders::ID id)
+	Mesh::Mesh(const MeshView & view) : m_material(view.material), m_color(view.color), m_boundingBox(view.boundingBox), m_boundingSphere(view.boundingSphere)
 	{
-		Shader::SetFloat3v(id, "color", m_color);
-
-		glBindVertexArray(m_VAO);
-		glDrawElements(GL_TRIANGLES, m_nrOfIndices, GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+		//Bounds were computed when the data was cooked, the data goes straight to the shared geometry arenas
+		m_range = GeometryBuffer::Allocate(view.vertices, view.vertexCount, view.indices, view.indexCount, view.lodCount, m_boundingBox);
+		m_dequantization = GeometryBuffer::GetDequantization(m_boundingBox);
 	}
 
 	void Mesh::Destroy()
 	{
-		glDeleteVertexArrays(1, &m_VAO);
-		glDeleteBuffers(1, &m_VBO);
-		glDeleteBuffers(1, &m_EBO);
+		GeometryBuffer::Free(m_range);
 	}
 
 	void Mesh::SetColor(glm::vec3 color)
@@ -28,40 +30,59 @@ namespace px
 		m_color = color;
 	}
 
-	glm::vec3 Mesh::GetColor()
+	glm::vec3 Mesh::GetColor() const
 	{
 		return m_color;
 	}
 
-	void Mesh::SetupMesh()
+	unsigned int Mesh::GetMaterial() const
+	{
+		return m_material;
+	}
+
+	unsigned int Mesh::GetLodCount() const
+	{
+		return m_range.lodCount;
+	}
+
+	const GeometryRange & Mesh::GetRange() const
 	{
-		m_nrOfVertices = m_vertices.size();
-		m_nrOfIndices = m_indices.size();
+		return m_range;
+	}
 
-		glGenVertexArrays(1, &m_VAO);
-		glGenBuffers(1, &m_VBO);
-		glGenBuffers(1, &m_EBO);
+	const glm::mat4 & Mesh::GetDequantization() const
+	{
+		return m_dequantization;
+	}
 
-		glBindVertexArray(m_VAO);
-		glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	const BoundingBox & Mesh::GetBoundingBox() const
+	{
+		return m_boundingBox;
+	}
 
-		glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(Vertex), &m_vertices[0], GL_STATIC_DRAW);
+	const BoundingSphere & Mesh::GetBoundingSphere() const
+	{
+		return m_boundingSphere;
+	}
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), &m_indices[0], GL_STATIC_DRAW);
+	void Mesh::ComputeBounds(const Vertex* vertices, unsigned int count, BoundingBox & boundingBox, BoundingSphere & boundingSphere)
+	{
+		for (unsigned int i = 0; i < count; i++)
+			boundingBox.Expand(vertices[i].position);
 
-		//Positions
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+		if (!boundingBox.IsValid())
+			return;
 
-		//Normals
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+		//Sphere around the box center, tight enough for the simple shapes we import
+		float radiusSquared = 0.f;
+		glm::vec3 center = boundingBox.GetCenter();
 
-		glBindVertexArray(0);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			glm::vec3 offset = vertices[i].position - center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
 
-		//Clear vectors from memory
-		std::vector<Vertex>().swap(m_vertices);
-		std::vector<unsigned int>().swap(m_indices);
+		boundingSphere = BoundingSphere(center, std::sqrt(radiusSquared));
 	}
 }
@@ -1,41 +1,44 @@
 #pragma once
 
 #include "Shader.hpp"
+#include "Bounds.hpp"
+#include "GeometryBuffer.hpp"
+#include "MeshCache.hpp"
 #include <memory>
 
 namespace px
 {
-	struct Vertex
-	{
-		//Only position and normal at this point
-		glm::vec3 position;
-		glm::vec3 normal;
-	};
-
 	class Mesh
 	{
 	public:
-		Mesh(std::vector<Vertex> & vertices, std::vector<unsigned int> & indices, glm::vec3 & color);
+		Mesh(std::vector<Vertex> & vertices, std::vector<unsigned int> & indices, glm::vec3 & color, unsigned int material);
+		explicit Mesh(const MeshView & view);
 
 	public:
-		void Draw(Shaders::ID id);
 		void Destroy();
 
 	public:
 		void SetColor(glm::vec3 color);
 
 	public:
-		glm::vec3 GetColor();
+		glm::vec3 GetColor() const;
+		unsigned int GetMaterial() const;
+		unsigned int GetLodCount() const;
+		const GeometryRange & GetRange() const;
+		const glm::mat4 & GetDequantization() const;
+		const BoundingBox & GetBoundingBox() const;
+		const BoundingSphere & GetBoundingSphere() const;
 
-	private:
-		void SetupMesh();
+	public:
+		static void ComputeBounds(const Vertex* vertices, unsigned int count, BoundingBox & boundingBox, BoundingSphere & boundingSphere);
 
 	private:
-		std::vector<Vertex> m_vertices;
-		std::vector<unsigned int> m_indices;
-		unsigned int m_VAO, m_VBO, m_EBO;
-		unsigned int m_nrOfVertices, m_nrOfIndices;
+		GeometryRange m_range;
+		glm::mat4 m_dequantization;
+		unsigned int m_material;
 		glm::vec3 m_color;
+		BoundingBox m_boundingBox;
+		BoundingSphere m_boundingSphere;
 	};
 }
 
@@ -0,0 +1,204 @@
+#include "MeshCache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace px
+{
+	namespace
+	{
+		const char MESH_CACHE_MAGIC[4] = { 'P', 'X', 'M', 'H' };
+		const std::uint64_t BLOB_ALIGNMENT = 16;
+
+		//On-disk layout, written and mapped as is
+		struct FileHeader
+		{
+			char magic[4];
+			std::uint32_t version;
+			std::uint64_t sourceSize;
+			std::int64_t sourceTime;
+			std::uint32_t meshCount;
+			std::uint32_t reserved;
+		};
+
+		struct FileMesh
+		{
+			std::uint32_t vertexCount;
+			std::uint32_t lodCount;
+			std::uint32_t material;
+			std::uint32_t reserved;
+			std::uint32_t indexCount[MAX_MESH_LODS];
+			float color[3];
+			float sphere[4];
+			float boxMin[3];
+			float boxMax[3];
+			float padding;
+			std::uint64_t vertexOffset;
+			std::uint64_t indexOffset[MAX_MESH_LODS];
+		};
+
+		static_assert(sizeof(FileHeader) == 32, "Mesh cache header layout changed");
+		static_assert(sizeof(FileMesh) == 128, "Mesh cache entry layout changed");
+		static_assert(sizeof(Vertex) == 24, "Mesh cache vertex layout changed");
+
+		std::uint64_t Align(std::uint64_t offset)
+		{
+			return (offset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+		}
+	}
+
+	std::string MeshCache::GetCachePath(const std::string & sourcePath)
+	{
+		//The extension stays in the name, model.obj and model.fbx are different sources
+		return sourcePath + ".pxmesh";
+	}
+
+	MeshView MeshCache::CreateView(const MeshData & mesh)
+	{
+		MeshView view;
+		view.vertices = mesh.vertices.data();
+		view.vertexCount = (unsigned int)mesh.vertices.size();
+		view.lodCount = (unsigned int)std::min<std::size_t>(mesh.lods.size() + 1, MAX_MESH_LODS);
+
+		for (unsigned int lod = 0; lod < view.lodCount; lod++)
+		{
+			const std::vector<unsigned int> & indices = (lod == 0) ? mesh.indices : mesh.lods[lod - 1];
+			view.indices[lod] = indices.data();
+			view.indexCount[lod] = (unsigned int)indices.size();
+		}
+
+		view.color = mesh.color;
+		view.material = mesh.material;
+		view.boundingBox = mesh.boundingBox;
+		view.boundingSphere = mesh.boundingSphere;
+
+		return view;
+	}
+
+	bool MeshCache::Write(const std::string & sourcePath, const std::vector<MeshData> & meshes)
+	{
+		FileHeader header;
+		std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+		header.version = MESH_CACHE_VERSION;
+		header.meshCount = (std::uint32_t)meshes.size();
+		header.reserved = 0;
+
+		if (!MappedFile::GetStamp(sourcePath, header.sourceSize, header.sourceTime))
+			return false;
+
+		//Lay out the blobs after the entry table
+		std::vector<FileMesh> entries(meshes.size());
+		std::uint64_t offset = sizeof(FileHeader) + entries.size() * sizeof(FileMesh);
+
+		for (std::size_t i = 0; i < meshes.size(); i++)
+		{
+			const MeshData & mesh = meshes[i];
+			FileMesh & entry = entries[i];
+			std::memset(&entry, 0, sizeof(FileMesh));
+
+			MeshView view = CreateView(mesh);
+			entry.vertexCount = view.vertexCount;
+			entry.lodCount = view.lodCount;
+			entry.material = mesh.material;
+			std::memcpy(entry.color, &mesh.color[0], sizeof(entry.color));
+			std::memcpy(entry.sphere, &mesh.boundingSphere.center[0], sizeof(float) * 3);
+			entry.sphere[3] = mesh.boundingSphere.radius;
+			std::memcpy(entry.boxMin, &mesh.boundingBox.min[0], sizeof(entry.boxMin));
+			std::memcpy(entry.boxMax, &mesh.boundingBox.max[0], sizeof(entry.boxMax));
+
+			entry.vertexOffset = offset = Align(offset);
+			offset += mesh.vertices.size() * sizeof(Vertex);
+
+			for (unsigned int lod = 0; lod < view.lodCount; lod++)
+			{
+				entry.indexCount[lod] = view.indexCount[lod];
+				entry.indexOffset[lod] = offset = Align(offset);
+				offset += view.indexCount[lod] * sizeof(unsigned int);
+			}
+		}
+
+		std::ofstream file(GetCachePath(sourcePath), std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		file.write((const char*)&header, sizeof(FileHeader));
+		file.write((const char*)entries.data(), entries.size() * sizeof(FileMesh));
+
+		static const char zeros[BLOB_ALIGNMENT] = {};
+		for (std::size_t i = 0; i < meshes.size(); i++)
+		{
+			file.write(zeros, entries[i].vertexOffset - (std::uint64_t)file.tellp());
+			file.write((const char*)meshes[i].vertices.data(), meshes[i].vertices.size() * sizeof(Vertex));
+
+			for (unsigned int lod = 0; lod < entries[i].lodCount; lod++)
+			{
+				const std::vector<unsigned int> & indices = (lod == 0) ? meshes[i].indices : meshes[i].lods[lod - 1];
+				file.write(zeros, entries[i].indexOffset[lod] - (std::uint64_t)file.tellp());
+				file.write((const char*)indices.data(), indices.size() * sizeof(unsigned int));
+			}
+		}
+
+		return file.good();
+	}
+
+	bool MeshCache::Read(const std::string & sourcePath, MappedFile & file, std::vector<MeshView> & meshes)
+	{
+		std::uint64_t sourceSize;
+		std::int64_t sourceTime;
+		if (!MappedFile::GetStamp(sourcePath, sourceSize, sourceTime))
+			return false;
+
+		if (!file.Open(GetCachePath(sourcePath)))
+			return false;
+
+		//Anything that doesn't match exactly is treated as a miss and gets re-cooked
+		const unsigned char* data = file.GetData();
+		std::size_t size = file.GetSize();
+
+		if (size < sizeof(FileHeader))
+			return false;
+
+		const FileHeader* header = (const FileHeader*)data;
+		if (std::memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(header->magic)) != 0 || header->version != MESH_CACHE_VERSION ||
+			header->sourceSize != sourceSize || header->sourceTime != sourceTime)
+			return false;
+
+		if (sizeof(FileHeader) + (std::uint64_t)header->meshCount * sizeof(FileMesh) > size)
+			return false;
+
+		const FileMesh* entries = (const FileMesh*)(data + sizeof(FileHeader));
+		meshes.clear();
+		meshes.reserve(header->meshCount);
+
+		for (std::uint32_t i = 0; i < header->meshCount; i++)
+		{
+			const FileMesh & entry = entries[i];
+			if (entry.lodCount == 0 || entry.lodCount > MAX_MESH_LODS || entry.vertexOffset + (std::uint64_t)entry.vertexCount * sizeof(Vertex) > size)
+				return false;
+
+			MeshView view;
+			view.vertices = (const Vertex*)(data + entry.vertexOffset);
+			view.vertexCount = entry.vertexCount;
+			view.lodCount = entry.lodCount;
+
+			for (unsigned int lod = 0; lod < entry.lodCount; lod++)
+			{
+				if (entry.indexOffset[lod] + (std::uint64_t)entry.indexCount[lod] * sizeof(unsigned int) > size)
+					return false;
+
+				view.indices[lod] = (const unsigned int*)(data + entry.indexOffset[lod]);
+				view.indexCount[lod] = entry.indexCount[lod];
+			}
+
+			view.color = glm::vec3(entry.color[0], entry.color[1], entry.color[2]);
+			view.material = entry.material;
+			view.boundingBox.min = glm::vec3(entry.boxMin[0], entry.boxMin[1], entry.boxMin[2]);
+			view.boundingBox.max = glm::vec3(entry.boxMax[0], entry.boxMax[1], entry.boxMax[2]);
+			view.boundingSphere = BoundingSphere(glm::vec3(entry.sphere[0], entry.sphere[1], entry.sphere[2]), entry.sphere[3]);
+
+			meshes.push_back(view);
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "GeometryBuffer.hpp"
+#include "Bounds.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace px
+{
+	//Bump whenever the cooked layout or the cooking steps change, stale caches are then re-cooked
+	const std::uint32_t MESH_CACHE_VERSION = 3;
+
+	//CPU side result of importing one mesh, this is what gets cooked
+	struct MeshData
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<std::vector<unsigned int>> lods;
+		glm::vec3 color;
+		unsigned int material;
+		BoundingBox boundingBox;
+		BoundingSphere boundingSphere;
+	};
+
+	//One mesh inside a mapped cache, the pointers are valid as long as the file stays mapped
+	struct MeshView
+	{
+		const Vertex* vertices;
+		unsigned int vertexCount;
+		//Entry 0 is the full detail mesh, the rest are the simplified LODs
+		const unsigned int* indices[MAX_MESH_LODS];
+		unsigned int indexCount[MAX_MESH_LODS];
+		unsigned int lodCount;
+		glm::vec3 color;
+		unsigned int material;
+		BoundingBox boundingBox;
+		BoundingSphere boundingSphere;
+	};
+
+	//Binary .pxmesh files cooked next to the source model
+	class MeshCache
+	{
+	public:
+		static std::string GetCachePath(const std::string & sourcePath);
+		static MeshView CreateView(const MeshData & mesh);
+
+	public:
+		static bool Write(const std::string & sourcePath, const std::vector<MeshData> & meshes);
+		static bool Read(const std::string & sourcePath, MappedFile & file, std::vector<MeshView> & meshes);
+	};
+}
@@ -0,0 +1,316 @@
+#include "MeshOptimizer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace px
+{
+	namespace
+	{
+		//Exact bitwise vertex identity, anything else is left for the simplifier
+		struct VertexHash
+		{
+			std::size_t operator()(const Vertex & vertex) const
+			{
+				const unsigned char* bytes = (const unsigned char*)&vertex;
+				std::size_t hash = 2166136261u;
+
+				for (std::size_t i = 0; i < sizeof(Vertex); i++)
+					hash = (hash ^ bytes[i]) * 16777619u;
+
+				return hash;
+			}
+		};
+
+		struct VertexEqual
+		{
+			bool operator()(const Vertex & a, const Vertex & b) const
+			{
+				return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+			}
+		};
+	}
+
+	MeshOptimizer::Statistics MeshOptimizer::Optimize(MeshData & mesh)
+	{
+		Statistics statistics;
+		statistics.verticesBefore = (unsigned int)mesh.vertices.size();
+		statistics.acmrBefore = ComputeACMR(mesh.indices, statistics.verticesBefore);
+		statistics.atvrBefore = ComputeATVR(mesh.indices, statistics.verticesBefore);
+
+		WeldVertices(mesh);
+		OptimizeVertexCache(mesh.indices, (unsigned int)mesh.vertices.size());
+		OptimizeOverdraw(mesh.indices, mesh.vertices);
+		OptimizeVertexFetch(mesh);
+
+		statistics.verticesAfter = (unsigned int)mesh.vertices.size();
+		statistics.acmrAfter = ComputeACMR(mesh.indices, statistics.verticesAfter);
+		statistics.atvrAfter = ComputeATVR(mesh.indices, statistics.verticesAfter);
+
+		return statistics;
+	}
+
+	void MeshOptimizer::WeldVertices(MeshData & mesh)
+	{
+		std::unordered_map<Vertex, unsigned int, VertexHash, VertexEqual> unique;
+		std::vector<Vertex> welded;
+		std::vector<unsigned int> remap(mesh.vertices.size());
+
+		unique.reserve(mesh.vertices.size());
+		welded.reserve(mesh.vertices.size());
+
+		for (std::size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			auto inserted = unique.insert(std::make_pair(mesh.vertices[i], (unsigned int)welded.size()));
+			if (inserted.second)
+				welded.push_back(mesh.vertices[i]);
+
+			remap[i] = inserted.first->second;
+		}
+
+		for (auto & index : mesh.indices)
+			index = remap[index];
+
+		mesh.vertices.swap(welded);
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int> & indices, unsigned int vertexCount)
+	{
+		//Tipsify (Sander, Nehab and Barczak 2007): fan around a vertex that is still in the cache and emit its remaining triangles
+		std::size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || vertexCount == 0)
+			return;
+
+		//Vertex to triangle adjacency in one flat array
+		std::vector<unsigned int> live(vertexCount, 0);
+		for (auto index : indices)
+			live[index]++;
+
+		std::vector<unsigned int> offsets(vertexCount + 1, 0);
+		for (unsigned int v = 0; v < vertexCount; v++)
+			offsets[v + 1] = offsets[v] + live[v];
+
+		std::vector<unsigned int> adjacency(indices.size());
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (std::size_t i = 0; i < indices.size(); i++)
+			adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+		std::vector<unsigned int> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<unsigned int> deadEnd;
+		std::vector<unsigned int> candidates;
+		std::vector<unsigned int> output;
+		output.reserve(indices.size());
+
+		int fanning = 0;
+		unsigned int timestamp = VERTEX_CACHE_SIZE + 1;
+		unsigned int cursor = 1;
+
+		while (fanning >= 0)
+		{
+			candidates.clear();
+
+			for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+			{
+				unsigned int triangle = adjacency[a];
+				if (emitted[triangle])
+					continue;
+
+				for (unsigned int corner = 0; corner < 3; corner++)
+				{
+					unsigned int v = indices[triangle * 3 + corner];
+					output.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+
+					if (timestamp - cacheTime[v] > VERTEX_CACHE_SIZE)
+						cacheTime[v] = timestamp++;
+				}
+
+				emitted[triangle] = true;
+			}
+
+			//Prefer the candidate that stays in the cache while its remaining triangles go out
+			int best = -1;
+			int bestPriority = -1;
+
+			for (auto v : candidates)
+			{
+				if (live[v] == 0)
+					continue;
+
+				int priority = 0;
+				if (timestamp - cacheTime[v] + 2 * live[v] <= VERTEX_CACHE_SIZE)
+					priority = (int)(timestamp - cacheTime[v]);
+
+				if (priority > bestPriority)
+				{
+					best = (int)v;
+					bestPriority = priority;
+				}
+			}
+
+			//Dead end, back off to recently used vertices and then to the next unfinished one in order
+			while (best < 0 && !deadEnd.empty())
+			{
+				unsigned int v = deadEnd.back();
+				deadEnd.pop_back();
+
+				if (live[v] > 0)
+					best = (int)v;
+			}
+
+			while (best < 0 && cursor < vertexCount)
+			{
+				if (live[cursor] > 0)
+					best = (int)cursor;
+				cursor++;
+			}
+
+			fanning = best;
+		}
+
+		indices.swap(output);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int> & indices, const std::vector<Vertex> & vertices, float threshold)
+	{
+		//Split the cache-ordered triangles into clusters where the cache restarts, then draw outward facing clusters first.
+		//Triangles inside a cluster keep their order so the cache efficiency mostly survives
+		std::size_t triangleCount = indices.size() / 3;
+		if (triangleCount < 2)
+			return;
+
+		std::vector<unsigned int> clusterStarts;
+		unsigned int vertexCount = (unsigned int)vertices.size();
+		float acmr = (float)CountCacheMisses(indices, vertexCount, &clusterStarts) / triangleCount;
+
+		if (clusterStarts.size() < 2)
+			return;
+
+		glm::vec3 meshCentroid(0.f);
+		for (auto & vertex : vertices)
+			meshCentroid += vertex.position;
+		meshCentroid /= (float)vertices.size();
+
+		struct Cluster
+		{
+			unsigned int first;
+			unsigned int count;
+			float sortKey;
+		};
+
+		std::vector<Cluster> clusters;
+		clusters.reserve(clusterStarts.size());
+
+		for (std::size_t c = 0; c < clusterStarts.size(); c++)
+		{
+			unsigned int first = clusterStarts[c];
+			unsigned int last = (c + 1 < clusterStarts.size()) ? clusterStarts[c + 1] : (unsigned int)triangleCount;
+
+			//Area weighted centroid and normal of the cluster
+			glm::vec3 centroid(0.f);
+			glm::vec3 normal(0.f);
+			float area = 0.f;
+
+			for (unsigned int t = first; t < last; t++)
+			{
+				const glm::vec3 & a = vertices[indices[t * 3 + 0]].position;
+				const glm::vec3 & b = vertices[indices[t * 3 + 1]].position;
+				const glm::vec3 & d = vertices[indices[t * 3 + 2]].position;
+
+				glm::vec3 cross = glm::cross(b - a, d - a);
+				float triangleArea = glm::length(cross);
+
+				centroid += (a + b + d) * (triangleArea / 3.f);
+				normal += cross;
+				area += triangleArea;
+			}
+
+			if (area > 0.f)
+				centroid /= area;
+
+			float normalLength = glm::length(normal);
+			float sortKey = normalLength > 0.f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.f;
+
+			clusters.push_back({ first, last - first, sortKey });
+		}
+
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster & a, const Cluster & b) { return a.sortKey > b.sortKey; });
+
+		std::vector<unsigned int> sorted;
+		sorted.reserve(indices.size());
+
+		for (auto & cluster : clusters)
+			sorted.insert(sorted.end(), indices.begin() + cluster.first * 3, indices.begin() + (cluster.first + cluster.count) * 3);
+
+		//Only keep the new order if it doesn't give back too much of the cache win
+		if ((float)CountCacheMisses(sorted, vertexCount) / triangleCount <= acmr * threshold)
+			indices.swap(sorted);
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(MeshData & mesh)
+	{
+		//Renumber vertices in the order the index buffer first touches them, unreferenced vertices are dropped
+		const unsigned int unused = ~0u;
+		std::vector<unsigned int> remap(mesh.vertices.size(), unused);
+		std::vector<Vertex> ordered;
+		ordered.reserve(mesh.vertices.size());
+
+		for (auto & index : mesh.indices)
+		{
+			if (remap[index] == unused)
+			{
+				remap[index] = (unsigned int)ordered.size();
+				ordered.push_back(mesh.vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		mesh.vertices.swap(ordered);
+	}
+
+	float MeshOptimizer::ComputeACMR(const std::vector<unsigned int> & indices, unsigned int vertexCount)
+	{
+		std::size_t triangleCount = indices.size() / 3;
+		return triangleCount > 0 ? (float)CountCacheMisses(indices, vertexCount) / triangleCount : 0.f;
+	}
+
+	float MeshOptimizer::ComputeATVR(const std::vector<unsigned int> & indices, unsigned int vertexCount)
+	{
+		return vertexCount > 0 ? (float)CountCacheMisses(indices, vertexCount) / vertexCount : 0.f;
+	}
+
+	unsigned int MeshOptimizer::CountCacheMisses(const std::vector<unsigned int> & indices, unsigned int vertexCount, std::vector<unsigned int>* clusterStarts)
+	{
+		//FIFO cache simulation, a vertex is resident while fewer than VERTEX_CACHE_SIZE misses happened after it entered
+		std::vector<unsigned int> enteredAt(vertexCount, 0);
+		unsigned int misses = 0;
+		unsigned int timestamp = VERTEX_CACHE_SIZE + 1;
+
+		for (std::size_t t = 0; t < indices.size() / 3; t++)
+		{
+			unsigned int triangleMisses = 0;
+
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				unsigned int v = indices[t * 3 + corner];
+				if (timestamp - enteredAt[v] > VERTEX_CACHE_SIZE)
+				{
+					enteredAt[v] = timestamp++;
+					triangleMisses++;
+				}
+			}
+
+			misses += triangleMisses;
+
+			//A triangle missing all three vertices starts over with a cold cache
+			if (clusterStarts && (t == 0 || triangleMisses == 3))
+				clusterStarts->push_back((unsigned int)t);
+		}
+
+		return misses;
+	}
+}
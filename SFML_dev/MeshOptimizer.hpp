@@ -0,0 +1,40 @@
+#pragma once
+#include "MeshCache.hpp"
+
+namespace px
+{
+	//Post-transform cache size the optimizer and the statistics assume
+	const unsigned int VERTEX_CACHE_SIZE = 16;
+
+	//Cooking stage run on freshly imported meshes before they are written to the cache
+	class MeshOptimizer
+	{
+	public:
+		struct Statistics
+		{
+			unsigned int verticesBefore;
+			unsigned int verticesAfter;
+			float acmrBefore;
+			float acmrAfter;
+			float atvrBefore;
+			float atvrAfter;
+		};
+
+	public:
+		static Statistics Optimize(MeshData & mesh);
+
+	public:
+		static void WeldVertices(MeshData & mesh);
+		static void OptimizeVertexCache(std::vector<unsigned int> & indices, unsigned int vertexCount);
+		static void OptimizeOverdraw(std::vector<unsigned int> & indices, const std::vector<Vertex> & vertices, float threshold = 1.05f);
+		static void OptimizeVertexFetch(MeshData & mesh);
+
+	public:
+		//Average cache miss ratio per triangle and per vertex for a FIFO cache of VERTEX_CACHE_SIZE entries
+		static float ComputeACMR(const std::vector<unsigned int> & indices, unsigned int vertexCount);
+		static float ComputeATVR(const std::vector<unsigned int> & indices, unsigned int vertexCount);
+
+	private:
+		static unsigned int CountCacheMisses(const std::vector<unsigned int> & indices, unsigned int vertexCount, std::vector<unsigned int>* clusterStarts = nullptr);
+	};
+}
@@ -0,0 +1,413 @@
+#include "MeshSimplifier.hpp"
+#include "MeshOptimizer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace px
+{
+	namespace
+	{
+		//A LOD has to drop at least this share of the previous level's triangles to be kept
+		const float MIN_LOD_REDUCTION = 0.1f;
+
+		//Cosine of the largest rotation a collapse may apply to a neighbouring triangle
+		const float MIN_NORMAL_COSINE = 0.25f;
+
+		struct Quadric
+		{
+			double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+		};
+
+		//The map compares with ==, which treats -0 and +0 as equal, so both have to hash the same
+		struct PositionHash
+		{
+			std::size_t operator()(const glm::vec3 & position) const
+			{
+				std::size_t hash = 2166136261u;
+
+				for (int i = 0; i < 3; i++)
+				{
+					float value = position[i] == 0.f ? 0.f : position[i];
+					const unsigned char* bytes = (const unsigned char*)&value;
+
+					for (std::size_t j = 0; j < sizeof(float); j++)
+						hash = (hash ^ bytes[j]) * 16777619u;
+				}
+
+				return hash;
+			}
+		};
+
+		struct Collapse
+		{
+			double cost;
+			unsigned int from;
+			unsigned int to;
+		};
+
+		void AddPlane(Quadric & quadric, const glm::dvec3 & normal, double distance, double weight)
+		{
+			quadric.a2 += weight * normal.x * normal.x;
+			quadric.ab += weight * normal.x * normal.y;
+			quadric.ac += weight * normal.x * normal.z;
+			quadric.ad += weight * normal.x * distance;
+			quadric.b2 += weight * normal.y * normal.y;
+			quadric.bc += weight * normal.y * normal.z;
+			quadric.bd += weight * normal.y * distance;
+			quadric.c2 += weight * normal.z * normal.z;
+			quadric.cd += weight * normal.z * distance;
+			quadric.d2 += weight * distance * distance;
+		}
+
+		Quadric Combine(const Quadric & a, const Quadric & b)
+		{
+			Quadric sum;
+			const double* left = &a.a2;
+			const double* right = &b.a2;
+			double* result = &sum.a2;
+
+			for (unsigned int i = 0; i < 10; i++)
+				result[i] = left[i] + right[i];
+
+			return sum;
+		}
+
+		double Evaluate(const Quadric & q, const glm::vec3 & point)
+		{
+			double x = point.x, y = point.y, z = point.z;
+
+			//v^T Q v with v = (x, y, z, 1)
+			double error = q.a2 * x * x + 2.0 * q.ab * x * y + 2.0 * q.ac * x * z + 2.0 * q.ad * x
+						 + q.b2 * y * y + 2.0 * q.bc * y * z + 2.0 * q.bd * y
+						 + q.c2 * z * z + 2.0 * q.cd * z
+						 + q.d2;
+
+			return std::max(error, 0.0);
+		}
+
+		//Collapses run on positions rather than vertices so normal seams don't block simplification,
+		//each output corner then picks the vertex at its new position whose normal matches best
+		class Simplifier
+		{
+		public:
+			explicit Simplifier(const MeshData & mesh) : m_mesh(mesh)
+			{
+				std::unordered_map<glm::vec3, unsigned int, PositionHash> unique;
+				m_group.resize(mesh.vertices.size());
+
+				for (unsigned int v = 0; v < mesh.vertices.size(); v++)
+				{
+					auto inserted = unique.insert(std::make_pair(mesh.vertices[v].position, (unsigned int)m_positions.size()));
+					if (inserted.second)
+					{
+						m_positions.push_back(mesh.vertices[v].position);
+						m_wedges.push_back(std::vector<unsigned int>());
+					}
+
+					m_group[v] = inserted.first->second;
+					m_wedges[m_group[v]].push_back(v);
+				}
+
+				for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+				{
+					unsigned int a = m_group[mesh.indices[i]], b = m_group[mesh.indices[i + 1]], c = m_group[mesh.indices[i + 2]];
+					if (a == b || b == c || a == c)
+						continue;
+
+					m_triangles.insert(m_triangles.end(), { a, b, c });
+					m_corners.insert(m_corners.end(), { mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2] });
+				}
+
+				ComputeQuadrics();
+				LockBorders();
+			}
+
+			std::size_t GetTriangleCount() const
+			{
+				return m_triangles.size() / 3;
+			}
+
+			void Reduce(std::size_t targetTriangles)
+			{
+				while (GetTriangleCount() > targetTriangles)
+				{
+					if (RunPass(targetTriangles) == 0)
+						break;
+				}
+			}
+
+			void Write(std::vector<unsigned int> & indices) const
+			{
+				indices.resize(m_corners.size());
+
+				for (std::size_t i = 0; i < m_corners.size(); i++)
+				{
+					unsigned int original = m_corners[i];
+					unsigned int group = m_triangles[i];
+
+					if (m_group[original] == group)
+					{
+						indices[i] = original;
+						continue;
+					}
+
+					//The corner moved onto another position, take the wedge there facing the same way
+					const glm::vec3 & normal = m_mesh.vertices[original].normal;
+					unsigned int best = m_wedges[group][0];
+					float bestDot = -2.f;
+
+					for (auto wedge : m_wedges[group])
+					{
+						float d = glm::dot(normal, m_mesh.vertices[wedge].normal);
+						if (d > bestDot)
+						{
+							best = wedge;
+							bestDot = d;
+						}
+					}
+
+					indices[i] = best;
+				}
+			}
+
+		private:
+			void ComputeQuadrics()
+			{
+				m_quadrics.assign(m_positions.size(), Quadric());
+				std::memset(m_quadrics.data(), 0, m_quadrics.size() * sizeof(Quadric));
+
+				for (std::size_t i = 0; i < m_triangles.size(); i += 3)
+				{
+					glm::dvec3 p0 = glm::dvec3(m_positions[m_triangles[i]]);
+					glm::dvec3 p1 = glm::dvec3(m_positions[m_triangles[i + 1]]);
+					glm::dvec3 p2 = glm::dvec3(m_positions[m_triangles[i + 2]]);
+
+					glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+					double area = glm::length(normal);
+					if (area <= 0.0)
+						continue;
+
+					normal /= area;
+					double distance = -glm::dot(normal, p0);
+
+					for (unsigned int corner = 0; corner < 3; corner++)
+						AddPlane(m_quadrics[m_triangles[i + corner]], normal, distance, area);
+				}
+			}
+
+			void LockBorders()
+			{
+				//Edges used by exactly one triangle are open borders, moving them would tear holes
+				std::vector<std::uint64_t> edges;
+				edges.reserve(m_triangles.size());
+
+				for (std::size_t i = 0; i < m_triangles.size(); i += 3)
+				{
+					for (unsigned int corner = 0; corner < 3; corner++)
+						edges.push_back(EdgeKey(m_triangles[i + corner], m_triangles[i + (corner + 1) % 3]));
+				}
+
+				std::sort(edges.begin(), edges.end());
+				m_locked.assign(m_positions.size(), false);
+
+				for (std::size_t i = 0; i < edges.size();)
+				{
+					std::size_t j = i;
+					while (j < edges.size() && edges[j] == edges[i])
+						j++;
+
+					if (j - i != 2)
+					{
+						m_locked[(unsigned int)(edges[i] >> 32)] = true;
+						m_locked[(unsigned int)(edges[i] & 0xffffffffu)] = true;
+					}
+
+					i = j;
+				}
+			}
+
+			unsigned int RunPass(std::size_t targetTriangles)
+			{
+				BuildAdjacency();
+
+				//One candidate per edge, in its cheaper direction
+				std::vector<std::uint64_t> edges;
+				edges.reserve(m_triangles.size());
+
+				for (std::size_t i = 0; i < m_triangles.size(); i += 3)
+				{
+					for (unsigned int corner = 0; corner < 3; corner++)
+						edges.push_back(EdgeKey(m_triangles[i + corner], m_triangles[i + (corner + 1) % 3]));
+				}
+
+				std::sort(edges.begin(), edges.end());
+				edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+				std::vector<Collapse> candidates;
+				candidates.reserve(edges.size());
+
+				for (auto edge : edges)
+				{
+					unsigned int a = (unsigned int)(edge >> 32);
+					unsigned int b = (unsigned int)(edge & 0xffffffffu);
+					if (m_locked[a] && m_locked[b])
+						continue;
+
+					Quadric combined = Combine(m_quadrics[a], m_quadrics[b]);
+					double costToB = m_locked[a] ? -1.0 : Evaluate(combined, m_positions[b]);
+					double costToA = m_locked[b] ? -1.0 : Evaluate(combined, m_positions[a]);
+
+					if (costToA < 0.0 || (costToB >= 0.0 && costToB <= costToA))
+						candidates.push_back({ costToB, a, b });
+					else
+						candidates.push_back({ costToA, b, a });
+				}
+
+				std::sort(candidates.begin(), candidates.end(), [](const Collapse & x, const Collapse & y) { return x.cost < y.cost; });
+
+				//Each collapse removes about two triangles, and a vertex may only take part once per pass
+				std::size_t budget = (GetTriangleCount() - targetTriangles) / 2 + 1;
+				std::vector<unsigned int> remap(m_positions.size());
+				for (unsigned int i = 0; i < remap.size(); i++)
+					remap[i] = i;
+
+				std::vector<bool> touched(m_positions.size(), false);
+				unsigned int collapses = 0;
+
+				for (auto & candidate : candidates)
+				{
+					if (touched[candidate.from] || touched[candidate.to] || Flips(candidate.from, candidate.to))
+						continue;
+
+					remap[candidate.from] = candidate.to;
+					m_quadrics[candidate.to] = Combine(m_quadrics[candidate.to], m_quadrics[candidate.from]);
+
+					//Everything around the collapsed vertex changes shape, leave it alone for the rest of the pass
+					for (unsigned int a = m_offsets[candidate.from]; a < m_offsets[candidate.from + 1]; a++)
+					{
+						unsigned int triangle = m_adjacency[a];
+						for (unsigned int corner = 0; corner < 3; corner++)
+							touched[m_triangles[triangle * 3 + corner]] = true;
+					}
+
+					touched[candidate.to] = true;
+
+					if (++collapses >= budget)
+						break;
+				}
+
+				ApplyRemap(remap);
+				return collapses;
+			}
+
+			bool Flips(unsigned int from, unsigned int to) const
+			{
+				const glm::vec3 & target = m_positions[to];
+
+				for (unsigned int a = m_offsets[from]; a < m_offsets[from + 1]; a++)
+				{
+					const unsigned int* triangle = &m_triangles[m_adjacency[a] * 3];
+					if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+						continue;
+
+					glm::vec3 p[3], moved[3];
+					for (unsigned int corner = 0; corner < 3; corner++)
+					{
+						p[corner] = m_positions[triangle[corner]];
+						moved[corner] = (triangle[corner] == from) ? target : p[corner];
+					}
+
+					glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+					glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+					//Reject large rotations as well, small ones add up over the passes into fold-overs
+					if (glm::dot(before, after) <= MIN_NORMAL_COSINE * glm::length(before) * glm::length(after))
+						return true;
+				}
+
+				return false;
+			}
+
+			void BuildAdjacency()
+			{
+				m_offsets.assign(m_positions.size() + 1, 0);
+				for (auto group : m_triangles)
+					m_offsets[group + 1]++;
+
+				for (std::size_t i = 1; i < m_offsets.size(); i++)
+					m_offsets[i] += m_offsets[i - 1];
+
+				std::vector<unsigned int> fill(m_offsets.begin(), m_offsets.end() - 1);
+				m_adjacency.resize(m_triangles.size());
+
+				for (std::size_t i = 0; i < m_triangles.size(); i++)
+					m_adjacency[fill[m_triangles[i]]++] = (unsigned int)(i / 3);
+			}
+
+			void ApplyRemap(const std::vector<unsigned int> & remap)
+			{
+				//Triangles that lost an edge are dropped together with their corners
+				std::size_t write = 0;
+
+				for (std::size_t i = 0; i < m_triangles.size(); i += 3)
+				{
+					unsigned int a = remap[m_triangles[i]], b = remap[m_triangles[i + 1]], c = remap[m_triangles[i + 2]];
+					if (a == b || b == c || a == c)
+						continue;
+
+					m_triangles[write] = a; m_triangles[write + 1] = b; m_triangles[write + 2] = c;
+					m_corners[write] = m_corners[i]; m_corners[write + 1] = m_corners[i + 1]; m_corners[write + 2] = m_corners[i + 2];
+					write += 3;
+				}
+
+				m_triangles.resize(write);
+				m_corners.resize(write);
+			}
+
+			static std::uint64_t EdgeKey(unsigned int a, unsigned int b)
+			{
+				return a < b ? ((std::uint64_t)a << 32) | b : ((std::uint64_t)b << 32) | a;
+			}
+
+		private:
+			const MeshData & m_mesh;
+			std::vector<unsigned int> m_group;
+			std::vector<glm::vec3> m_positions;
+			std::vector<std::vector<unsigned int>> m_wedges;
+			std::vector<unsigned int> m_triangles;
+			std::vector<unsigned int> m_corners;
+			std::vector<Quadric> m_quadrics;
+			std::vector<bool> m_locked;
+			std::vector<unsigned int> m_offsets;
+			std::vector<unsigned int> m_adjacency;
+		};
+	}
+
+	void MeshSimplifier::GenerateLods(MeshData & mesh, const float* ratios, unsigned int ratioCount)
+	{
+		mesh.lods.clear();
+
+		std::size_t fullTriangles = mesh.indices.size() / 3;
+		if (fullTriangles == 0)
+			return;
+
+		//Each level continues collapsing from the previous one, and gets its own vertex cache order
+		Simplifier simplifier(mesh);
+		std::size_t previousTriangles = fullTriangles;
+
+		for (unsigned int i = 0; i < ratioCount; i++)
+		{
+			simplifier.Reduce((std::size_t)(fullTriangles * ratios[i]));
+
+			std::size_t triangles = simplifier.GetTriangleCount();
+			if (triangles == 0 || triangles > previousTriangles * (1.f - MIN_LOD_REDUCTION))
+				break;
+
+			mesh.lods.push_back(std::vector<unsigned int>());
+			simplifier.Write(mesh.lods.back());
+			MeshOptimizer::OptimizeVertexCache(mesh.lods.back(), (unsigned int)mesh.vertices.size());
+			previousTriangles = triangles;
+		}
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "MeshCache.hpp"
+
+namespace px
+{
+	//Quadric error edge collapse (Garland and Heckbert 1997) restricted to existing vertices,
+	//so every LOD is just another index list over the full resolution vertex data
+	class MeshSimplifier
+	{
+	public:
+		//Appends coarser index lists to mesh.lods at the given fractions of the full triangle count,
+		//stops early once a step no longer removes a meaningful number of triangles
+		static void GenerateLods(MeshData & mesh, const float* ratios, unsigned int ratioCount);
+	};
+}
@@ -1,149 +1,536 @@
 #pragma once
 #include "Mesh.hpp"
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "ThreadPool.hpp"
+#include "imgui_log.h"
+#include "AssetRegistry.hpp"
+#include "ResourceIdentifiers.hpp"
 
 #include <map>
+#include <deque>
+#include <chrono>
+#include <mutex>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <iostream>
+#include <cstring>
 
 namespace px
 {
-	template <typename Identifier>
+	//Bytes of mesh data uploaded per frame, a large model is spread over several frames instead of hitching one
+	const std::size_t MODEL_UPLOAD_BUDGET = 4 << 20;
+
+	//Triangle fractions of the generated LODs, relative to the full detail mesh
+	const float MODEL_LOD_RATIOS[MAX_MESH_LODS - 1] = { 0.5f, 0.25f, 0.1f };
+
+	//GPU bytes of unreferenced models kept resident before the least recently drawn ones are evicted
+	const std::size_t MODEL_MEMORY_BUDGET = 256 << 20;
+
+	//Meshes of one loaded model file
+	struct ModelAsset
+	{
+		std::vector<std::unique_ptr<Mesh>> meshes;
+		BoundingSphere bounds;
+	};
+
+	//Models are addressed by path, entities hold a reference through a ModelHandle for as long as they use it
 	class Model
 	{
 	public:
-		void LoadModel(Identifier id, std::string const & path);
-		void Draw(Identifier id, Shaders::ID shaderID);
-		void Destroy(Identifier id);
+		typedef AssetRegistry<ModelAsset> Registry;
+
+	public:
+		explicit Model(std::shared_ptr<ThreadPool> threadPool);
+
+	public:
+		//Returns right away, a new path draws as a placeholder until ProcessUploads() has finished it
+		ModelHandle Acquire(const std::string & path);
+		void AddReference(ModelHandle model);
+		void Release(ModelHandle model);
+		void ProcessUploads();
+
+		//Unloads every model and the placeholder, for shutdown before the geometry buffer is released
+		void Clear();
 
 	public:
-		void SetColor(Identifier id, glm::vec3 color);
+		void SetColor(ModelHandle model, glm::vec3 color);
+		void SetMemoryBudget(std::size_t bytes);
 
 	public:
-		glm::vec3 GetColor(Identifier id);
+		bool IsLoaded(ModelHandle model) const;
+		unsigned int GetPendingLoads() const;
+		std::size_t GetMemoryBudget() const;
+		std::string GetPath(ModelHandle model) const;
+		glm::vec3 GetColor(ModelHandle model);
+		const std::vector<std::unique_ptr<Mesh>> & GetMeshes(ModelHandle model);
+		const BoundingSphere & GetBoundingSphere(ModelHandle model);
+		const Registry & GetRegistry() const;
+
+	private:
+		typedef std::chrono::high_resolution_clock Clock;
+
+		//Filled on a worker, the views point either into the mapped cache or into the imported data
+		struct LoadResult
+		{
+			ModelHandle model;
+			std::string path;
+			std::unique_ptr<MappedFile> file;
+			std::vector<MeshData> imported;
+			std::vector<MeshView> views;
+			std::string error;
+			MeshOptimizer::Statistics optimization;
+			unsigned int lodTriangles[MAX_MESH_LODS];
+			bool cacheHit;
+			Clock::time_point requested;
+			double parseTime;
+		};
+
+		//Shared with the workers so a load finishing after the model holder is gone stays safe
+		struct LoadQueue
+		{
+			std::mutex mutex;
+			std::deque<std::unique_ptr<LoadResult>> finished;
+		};
+
+		//Model currently being uploaded, it is swapped in once every mesh is on the GPU
+		struct Upload
+		{
+			std::unique_ptr<LoadResult> result;
+			std::vector<std::unique_ptr<Mesh>> meshes;
+			std::size_t next;
+			double uploadTime;
+		};
+
+	private:
+		static void RunLoad(LoadResult & result);
+		static void OptimizeMeshes(LoadResult & result);
+		static void GenerateLods(LoadResult & result);
+		static bool ImportModel(std::string const & path, std::vector<MeshData> & meshes, std::string & error);
+		static void ProcessNode(aiNode* node, const aiScene* scene, std::vector<MeshData> & meshes);
+		static MeshData ProcessMesh(aiMesh* mesh, const aiScene* scene);
+		static MeshData CreatePlaceholder();
+		static void Unload(ModelAsset & asset);
 
 	private:
-		void ProcessNode(Identifier id, aiNode* node, const aiScene* scene);
-		std::unique_ptr<Mesh> ProcessMesh(Identifier id, aiMesh* mesh, const aiScene* scene);
+		void StartLoad(ModelHandle model, const std::string & path);
+		void UploadFinished();
+		void FinishUpload();
 
 	private:
-		std::map<Identifier, std::vector<std::unique_ptr<Mesh>>> m_models;
-		std::vector<std::unique_ptr<Mesh>> m_meshes;
-		std::string m_directory;
+		Registry m_registry;
+		std::map<std::uint32_t, glm::vec3> m_pendingColors;
+		std::vector<std::unique_ptr<Mesh>> m_placeholder;
+		std::shared_ptr<ThreadPool> m_threadPool;
+		std::shared_ptr<LoadQueue> m_queue;
+		Upload m_upload;
+		std::size_t m_memoryBudget;
+		unsigned int m_pendingLoads;
 	};
 
-	template <typename Identifier>
-	inline void Model<Identifier>::LoadModel(Identifier id, std::string const & path)
+	inline Model::Model(std::shared_ptr<ThreadPool> threadPool) : m_threadPool(threadPool), m_queue(std::make_shared<LoadQueue>()), m_memoryBudget(MODEL_MEMORY_BUDGET), 
+																  m_pendingLoads(0)
 	{
-		//Read file via ASSIMP
-		Assimp::Importer importer;
-		const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate);
+		MeshData cube = CreatePlaceholder();
+		m_placeholder.push_back(std::make_unique<Mesh>(MeshCache::CreateView(cube)));
+	}
 
-		//Check for errors
-		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) //If is Not Zero
+	inline ModelHandle Model::Acquire(const std::string & path)
+	{
+		//Every entity asking for a path that is already loaded or loading shares the same model
+		bool created = false;
+		ModelHandle model = m_registry.Acquire(path, created);
+
+		if (created)
+			StartLoad(model, path);
+
+		return model;
+	}
+
+	inline void Model::AddReference(ModelHandle model)
+	{
+		m_registry.AddReference(model);
+	}
+
+	inline void Model::Release(ModelHandle model)
+	{
+		m_registry.Release(model);
+	}
+
+	inline void Model::StartLoad(ModelHandle model, const std::string & path)
+	{
+		LoadResult* result = new LoadResult();
+		result->model = model;
+		result->path = path;
+		result->cacheHit = false;
+		result->parseTime = 0.0;
+		std::memset(&result->optimization, 0, sizeof(MeshOptimizer::Statistics));
+		std::memset(result->lodTriangles, 0, sizeof(result->lodTriangles));
+		result->requested = Clock::now();
+
+		std::shared_ptr<LoadQueue> queue = m_queue;
+		m_threadPool->Enqueue([result, queue]
 		{
-			std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+			RunLoad(*result);
+
+			std::lock_guard<std::mutex> lock(queue->mutex);
+			queue->finished.emplace_back(result);
+		});
+
+		m_pendingLoads++;
+	}
+
+	inline void Model::ProcessUploads()
+	{
+		m_registry.NextFrame();
+		UploadFinished();
+
+		unsigned int evicted = m_registry.Evict(m_memoryBudget, &Model::Unload);
+		if (evicted > 0)
+			gameLog.Print("Evicted %u model(s), %.2f MB resident\n", evicted, m_registry.GetStatistics().gpuBytes / (1024.0 * 1024.0));
+	}
+
+	inline void Model::UploadFinished()
+	{
+		std::size_t budget = MODEL_UPLOAD_BUDGET;
+
+		while (budget > 0)
+		{
+			if (!m_upload.result)
+			{
+				std::lock_guard<std::mutex> lock(m_queue->mutex);
+				if (m_queue->finished.empty())
+					return;
+
+				m_upload.result = std::move(m_queue->finished.front());
+				m_queue->finished.pop_front();
+				m_upload.meshes.clear();
+				m_upload.next = 0;
+				m_upload.uploadTime = 0.0;
+			}
+
+			//At least one mesh goes up per frame, even if it alone is over the budget
+			const std::vector<MeshView> & views = m_upload.result->views;
+			Clock::time_point start = Clock::now();
+
+			while (m_upload.next < views.size() && budget > 0)
+			{
+				const MeshView & view = views[m_upload.next++];
+				m_upload.meshes.push_back(std::make_unique<Mesh>(view));
+
+				std::size_t bytes = view.vertexCount * sizeof(Vertex);
+				for (unsigned int lod = 0; lod < view.lodCount; lod++)
+					bytes += view.indexCount[lod] * sizeof(unsigned int);
+				budget -= std::min(budget, bytes);
+			}
+
+			m_upload.uploadTime += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			if (m_upload.next < views.size())
+				return;
+
+			FinishUpload();
+		}
+	}
+
+	inline void Model::Clear()
+	{
+		m_registry.Clear(&Model::Unload);
+		m_pendingColors.clear();
+
+		for (auto & mesh : m_placeholder)
+			mesh->Destroy();
+	}
+
+	inline void Model::SetColor(ModelHandle model, glm::vec3 color) //This need some kind of index for child nodes
+	{
+		//Applied once the model has finished loading
+		ModelAsset* asset = m_registry.Get(model);
+		if (!asset)
+		{
+			if (m_registry.IsValid(model))
+				m_pendingColors[model.index] = color;
 			return;
 		}
 
-		//Retrieve the directory path of the filepath
-		m_directory = path.substr(0, path.find_last_of('/'));
-		ProcessNode(id, scene->mRootNode, scene);
+		for (auto & mesh : asset->meshes)
+			mesh->SetColor(color);
+	}
+
+	inline void Model::SetMemoryBudget(std::size_t bytes)
+	{
+		m_memoryBudget = bytes;
 	}
 
-	template <typename Identifier>
-	inline void Model<Identifier>::Draw(Identifier id, Shaders::ID shaderID)
+	inline bool Model::IsLoaded(ModelHandle model) const
 	{
-		auto found = m_models.find(id);
-		assert(found != m_models.end());
+		return m_registry.Get(model) != nullptr;
+	}
 
-		for (auto & mesh : found->second)
-			mesh->Draw(shaderID);
+	inline unsigned int Model::GetPendingLoads() const
+	{
+		return m_pendingLoads;
 	}
 
-	template <typename Identifier>
-	inline void Model<Identifier>::SetColor(Identifier id, glm::vec3 color) //This need some kind of index for child nodes
+	inline std::size_t Model::GetMemoryBudget() const
 	{
-		auto found = m_models.find(id);
-		assert(found != m_models.end());
+		return m_memoryBudget;
+	}
 
-		for (auto & mesh : found->second)
-			mesh->SetColor(color);
+	inline std::string Model::GetPath(ModelHandle model) const
+	{
+		const Registry::Entry* entry = m_registry.GetEntry(model);
+		return entry ? entry->path : std::string();
 	}
 
-	template <typename Identifier>
-	inline glm::vec3 Model<Identifier>::GetColor(Identifier id) //This need some kind of index for child nodes
+	inline glm::vec3 Model::GetColor(ModelHandle model) //This need some kind of index for child nodes
 	{
-		auto found = m_models.find(id);
-		assert(found != m_models.end());
+		ModelAsset* asset = m_registry.Get(model);
+		if (!asset)
+		{
+			auto pending = m_pendingColors.find(model.index);
+			return (pending != m_pendingColors.end() && m_registry.IsValid(model)) ? pending->second : m_placeholder[0]->GetColor();
+		}
 
-		for (auto & mesh : found->second)
+		for (auto & mesh : asset->meshes)
 			return mesh->GetColor();
 
 		return glm::vec3();
 	}
 
-	template <typename Identifier>
-	inline void Model<Identifier>::Destroy(Identifier id)
+	inline const std::vector<std::unique_ptr<Mesh>> & Model::GetMeshes(ModelHandle model)
+	{
+		//Asked for every drawn instance, which doubles as the usage stamp for eviction
+		ModelAsset* asset = m_registry.Get(model);
+		if (!asset)
+			return m_placeholder;
+
+		m_registry.Touch(model);
+		return asset->meshes;
+	}
+
+	inline const BoundingSphere & Model::GetBoundingSphere(ModelHandle model)
+	{
+		ModelAsset* asset = m_registry.Get(model);
+		if (!asset)
+			return m_placeholder[0]->GetBoundingSphere();
+
+		return asset->bounds;
+	}
+
+	inline const Model::Registry & Model::GetRegistry() const
 	{
-		auto found = m_models.find(id);
-		assert(found != m_models.end());
+		return m_registry;
+	}
 
-		for (auto & mesh : found->second)
+	inline void Model::Unload(ModelAsset & asset)
+	{
+		for (auto & mesh : asset.meshes)
 			mesh->Destroy();
 	}
 
-	template <typename Identifier>
-	inline void Model<Identifier>::ProcessNode(Identifier id, aiNode * node, const aiScene * scene)
+	inline void Model::FinishUpload()
+	{
+		LoadResult & result = *m_upload.result;
+		double totalTime = std::chrono::duration<double, std::milli>(Clock::now() - result.requested).count();
+
+		if (!result.error.empty())
+		{
+			gameLog.Print("Failed to load %s: %s\n", result.path.c_str(), result.error.c_str());
+			m_registry.SetFailed(result.model);
+		}
+		else if (!m_registry.IsValid(result.model))
+		{
+			//Cleared while the load was in flight, nobody wants these meshes anymore
+			for (auto & mesh : m_upload.meshes)
+				mesh->Destroy();
+		}
+		else
+		{
+			auto asset = std::make_unique<ModelAsset>();
+			asset->meshes = std::move(m_upload.meshes);
+
+			//Bounds of the whole model, used for culling
+			std::size_t gpuBytes = 0;
+			for (unsigned int i = 0; i < asset->meshes.size(); i++)
+			{
+				const Mesh & mesh = *asset->meshes[i];
+				asset->bounds = (i == 0) ? mesh.GetBoundingSphere() : BoundingSphere::Merge(asset->bounds, mesh.GetBoundingSphere());
+				gpuBytes += GeometryBuffer::GetAllocationSize(mesh.GetRange());
+			}
+
+			std::size_t cpuBytes = sizeof(ModelAsset) + asset->meshes.size() * (sizeof(Mesh) + sizeof(std::unique_ptr<Mesh>));
+			m_registry.SetLoaded(result.model, std::move(asset), cpuBytes, gpuBytes);
+
+			auto pending = m_pendingColors.find(result.model.index);
+			if (pending != m_pendingColors.end())
+			{
+				SetColor(result.model, pending->second);
+				m_pendingColors.erase(pending);
+			}
+
+			gameLog.Print("Loaded %s in %.2f ms (%s, parse %.2f ms, upload %.2f ms)\n", result.path.c_str(), totalTime,
+						  result.cacheHit ? "cache hit" : "imported", result.parseTime, m_upload.uploadTime);
+
+			const MeshOptimizer::Statistics & optimization = result.optimization;
+			if (!result.cacheHit)
+			{
+				gameLog.Print("  Optimized: %u -> %u vertices, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", optimization.verticesBefore, optimization.verticesAfter,
+							  optimization.acmrBefore, optimization.acmrAfter, optimization.atvrBefore, optimization.atvrAfter);
+				gameLog.Print("  LODs: %u / %u / %u / %u triangles\n", result.lodTriangles[0], result.lodTriangles[1], result.lodTriangles[2], result.lodTriangles[3]);
+			}
+		}
+
+		//Releasing the result also unmaps the cache file
+		m_upload.result.reset();
+		m_upload.meshes.clear();
+		m_pendingLoads--;
+	}
+
+	inline void Model::RunLoad(LoadResult & result)
+	{
+		Clock::time_point start = Clock::now();
+		result.file = std::make_unique<MappedFile>();
+
+		//Upload straight from the mapped cache when it was cooked from the current source, otherwise import and re-cook
+		if (MeshCache::Read(result.path, *result.file, result.views))
+		{
+			result.cacheHit = true;
+
+			//Fault the pages in here so the upload on the main thread never waits for the disk
+			const unsigned char* data = result.file->GetData();
+			volatile unsigned char touched = 0;
+			for (std::size_t i = 0; i < result.file->GetSize(); i += 4096)
+				touched ^= data[i];
+		}
+		else
+		{
+			result.file.reset();
+			result.views.clear();
+
+			if (ImportModel(result.path, result.imported, result.error))
+			{
+				OptimizeMeshes(result);
+				GenerateLods(result);
+
+				if (!MeshCache::Write(result.path, result.imported))
+					std::cout << "WARNING::MESHCACHE:: Could not write " << MeshCache::GetCachePath(result.path) << std::endl;
+
+				for (auto & data : result.imported)
+					result.views.push_back(MeshCache::CreateView(data));
+			}
+		}
+
+		result.parseTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	inline void Model::OptimizeMeshes(LoadResult & result)
+	{
+		//Weld and reorder before cooking, the statistics are combined over all meshes for the log
+		MeshOptimizer::Statistics & total = result.optimization;
+		unsigned int triangles = 0;
+
+		for (auto & data : result.imported)
+		{
+			unsigned int meshTriangles = (unsigned int)data.indices.size() / 3;
+			MeshOptimizer::Statistics statistics = MeshOptimizer::Optimize(data);
+
+			total.verticesBefore += statistics.verticesBefore;
+			total.verticesAfter += statistics.verticesAfter;
+			total.acmrBefore += statistics.acmrBefore * meshTriangles;
+			total.acmrAfter += statistics.acmrAfter * meshTriangles;
+			total.atvrBefore += statistics.atvrBefore * statistics.verticesBefore;
+			total.atvrAfter += statistics.atvrAfter * statistics.verticesAfter;
+			triangles += meshTriangles;
+
+			//Unreferenced vertices are gone after the fetch reorder
+			data.boundingBox = BoundingBox();
+			Mesh::ComputeBounds(data.vertices.data(), (unsigned int)data.vertices.size(), data.boundingBox, data.boundingSphere);
+		}
+
+		if (triangles > 0)
+		{
+			total.acmrBefore /= triangles;
+			total.acmrAfter /= triangles;
+		}
+
+		if (total.verticesBefore > 0)
+			total.atvrBefore /= total.verticesBefore;
+		if (total.verticesAfter > 0)
+			total.atvrAfter /= total.verticesAfter;
+	}
+
+	inline void Model::GenerateLods(LoadResult & result)
+	{
+		//Meshes that can't be reduced any further simply end up with fewer levels
+		for (auto & data : result.imported)
+		{
+			MeshSimplifier::GenerateLods(data, MODEL_LOD_RATIOS, MAX_MESH_LODS - 1);
+
+			result.lodTriangles[0] += (unsigned int)data.indices.size() / 3;
+			for (unsigned int lod = 1; lod < MAX_MESH_LODS; lod++)
+			{
+				const std::vector<unsigned int> & indices = (lod <= data.lods.size()) ? data.lods[lod - 1] : data.lods.empty() ? data.indices : data.lods.back();
+				result.lodTriangles[lod] += (unsigned int)indices.size() / 3;
+			}
+		}
+	}
+
+	inline bool Model::ImportModel(std::string const & path, std::vector<MeshData> & meshes, std::string & error)
+	{
+		//Read file via ASSIMP
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate);
+
+		//Check for errors
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) //If is Not Zero
+		{
+			error = std::string("ERROR::ASSIMP:: ") + importer.GetErrorString();
+			return false;
+		}
+
+		ProcessNode(scene->mRootNode, scene, meshes);
+
+		return true;
+	}
+
+	inline void Model::ProcessNode(aiNode * node, const aiScene * scene, std::vector<MeshData> & meshes)
 	{
 		//Process each mesh located at the current node
 		for (unsigned int i = 0; i < node->mNumMeshes; i++)
 		{
 			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-			m_meshes.push_back(std::move(ProcessMesh(id, mesh, scene)));
+			meshes.push_back(ProcessMesh(mesh, scene));
 		}
 
 		//Process children if any after the meshes
 		for (unsigned int i = 0; i < node->mNumChildren; i++)
-			ProcessNode(id, node->mChildren[i], scene);
-
-		//Add the final model to the container
-		m_models.insert(std::make_pair(id, std::move(m_meshes)));
+			ProcessNode(node->mChildren[i], scene, meshes);
 	}
 
-	template <typename Identifier>
-	inline std::unique_ptr<Mesh> Model<Identifier>::ProcessMesh(Identifier id, aiMesh * mesh, const aiScene * scene)
+	inline MeshData Model::ProcessMesh(aiMesh * mesh, const aiScene * scene)
 	{
-		std::vector<Vertex> vertices;
-		std::vector<unsigned int> indices;
-		glm::vec3 vertexColor;
+		MeshData data;
 
 		//Walk through each of the mesh's vertices
+		data.vertices.resize(mesh->mNumVertices);
 		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 		{
-			Vertex vertex;
-			glm::vec3 vector;
-
-			//Position
-			vector = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
-			vertex.position = vector;
-
-			//Normals
-			vector = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
-			vertex.normal = vector;
-
-			vertices.push_back(vertex);
+			Vertex & vertex = data.vertices[i];
+			vertex.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+			vertex.normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
 		}
 
-		//Go through the faces
+		//Go through the faces, everything is triangulated on import
+		data.indices.reserve(mesh->mNumFaces * 3);
 		for (unsigned int i = 0; i < mesh->mNumFaces; i++)
 		{
-			aiFace face = mesh->mFaces[i];
+			const aiFace & face = mesh->mFaces[i];
 
 			//Retrieve indices
 			for (unsigned int j = 0; j < face.mNumIndices; j++)
-				indices.push_back(face.mIndices[j]);
+				data.indices.push_back(face.mIndices[j]);
 		}
 
 		//Color materials
@@ -151,9 +538,40 @@ namespace px
 
 		aiColor3D color(0.f, 0.f, 0.f);
 		material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
-		vertexColor = glm::vec3(color.r, color.g, color.b);
+		data.color = glm::vec3(color.r, color.g, color.b);
+		data.material = mesh->mMaterialIndex;
+
+		return data;
+	}
+
+	inline MeshData Model::CreatePlaceholder()
+	{
+		//Grey cube matching the default picking box, shown while the real model loads
+		MeshData data;
+		const glm::vec3 normals[6] = { glm::vec3(1.f, 0.f, 0.f), glm::vec3(-1.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f),
+									   glm::vec3(0.f, -1.f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 0.f, -1.f) };
+
+		for (unsigned int i = 0; i < 6; i++)
+		{
+			//Two axes spanning the face, u x v == normal keeps the winding counter-clockwise from outside
+			glm::vec3 normal = normals[i];
+			glm::vec3 u = glm::vec3(normal.y, normal.z, normal.x);
+			glm::vec3 v = glm::cross(normal, u);
+			unsigned int base = (unsigned int)data.vertices.size();
+
+			data.vertices.push_back({ normal - u - v, normal });
+			data.vertices.push_back({ normal + u - v, normal });
+			data.vertices.push_back({ normal + u + v, normal });
+			data.vertices.push_back({ normal - u + v, normal });
+
+			unsigned int quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+			data.indices.insert(data.indices.end(), quad, quad + 6);
+		}
+
+		data.color = glm::vec3(0.5f);
+		data.material = 0;
+		Mesh::ComputeBounds(data.vertices.data(), (unsigned int)data.vertices.size(), data.boundingBox, data.boundingSphere);
 
-		auto object = std::make_unique<Mesh>(vertices, indices, vertexColor);
-		return object;
+		return data;
 	}
 }
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace px
+{
+	typedef std::uint32_t NameID;
+	const NameID INVALID_NAME = 0xffffffff;
+
+	//Interns strings so they can be stored and compared as small integers. IDs are handed out in order and stay
+	//valid for the lifetime of the table, strings are never removed
+	class NameTable
+	{
+	public:
+		NameID Intern(const std::string & name);
+
+		//INVALID_NAME when the string was never interned
+		NameID Find(const std::string & name) const;
+		const std::string & GetString(NameID id) const;
+		unsigned int GetCount() const;
+
+	private:
+		std::unordered_map<std::string, NameID> m_ids;
+
+		//Point at the keys above, map nodes never move
+		std::vector<const std::string*> m_strings;
+	};
+
+	inline NameID NameTable::Intern(const std::string & name)
+	{
+		auto inserted = m_ids.emplace(name, (NameID)m_strings.size());
+		if (inserted.second)
+			m_strings.push_back(&inserted.first->first);
+
+		return inserted.first->second;
+	}
+
+	inline NameID NameTable::Find(const std::string & name) const
+	{
+		auto found = m_ids.find(name);
+		return found == m_ids.end() ? INVALID_NAME : found->second;
+	}
+
+	inline const std::string & NameTable::GetString(NameID id) const
+	{
+		return *m_strings[id];
+	}
+
+	inline unsigned int NameTable::GetCount() const
+	{
+		return (unsigned int)m_strings.size();
+	}
+}
@@ -1,4 +1,5 @@
 #include "Physics.hpp"
+#include "JobSystem.hpp"
 
 
 namespace px
@@ -10,7 +11,7 @@ namespace px
 	btCollisionDispatcher* Physics::m_dispatcher;
 	btSequentialImpulseConstraintSolver* Physics::m_solver;
 
-	void Physics::Init(std::shared_ptr<Camera> & camera)
+	void Physics::Init()
 	{
 		//Build the broadphase
 		m_broadphase = new btDbvtBroadphase();
@@ -27,7 +28,7 @@ namespace px
 		m_dynamicsWorld->setGravity(btVector3(0, -9.82, 0));
 
 		//Debug draw
-		m_debugDraw = new BulletDebugDraw(camera);
+		m_debugDraw = new BulletDebugDraw();
 		m_debugDraw->setDebugMode(btIDebugDraw::DBG_DrawWireframe);
 
 		m_dynamicsWorld->setDebugDrawer(m_debugDraw);
@@ -41,6 +42,11 @@ namespace px
 		//will simply be activated enabled in the simulation?
 	}
 
+	void Physics::UpdateAsync(JobCounter & counter)
+	{
+		JobSystem::Run([] { Update(); }, &counter);
+	}
+
 	void Physics::Release()
 	{
 		delete m_broadphase;
@@ -53,7 +59,9 @@ namespace px
 
 	void Physics::DrawDebug()
 	{
+		//Bullet only fills the batch, the lines are drawn in one go afterwards
 		m_dynamicsWorld->debugDrawWorld();
+		m_debugDraw->Flush();
 	}
 
 	BulletDebugDraw * Physics::GetDebugDraw()
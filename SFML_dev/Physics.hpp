@@ -15,11 +15,15 @@ namespace px
 		};
 	}
 
+	class JobCounter;
+
 	class Physics
 	{
 	public:
-		static void Init(std::shared_ptr<Camera> & camera);
+		static void Init();
 		static void Update();
+		//Steps the simulation as a job, nothing may touch the world until the counter is done
+		static void UpdateAsync(JobCounter & counter);
 		static void Release();
 		static void DrawDebug();
 
@@ -1,13 +1,15 @@
 #pragma once
-#include <memory>
 #include "PickingBody.hpp"
 
 namespace px
 {
+	//Plain data stored by value in the entity pool, the body belongs to the dynamics world and is created and
+	//destroyed through PickingBody
 	struct Pickable
 	{
-		explicit Pickable(std::unique_ptr<PickingBody> & object) : object(std::move(object)) {}
+		Pickable(btRigidBody* body, RigidBodyType::ID type) : body(body), type(type) {}
 
-		std::unique_ptr<PickingBody> object;
+		btRigidBody* body;
+		RigidBodyType::ID type;
 	};
 }
\ No newline at end of file
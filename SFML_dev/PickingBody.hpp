@@ -3,29 +3,14 @@
 
 namespace px
 {
+	//Static bodies used for mouse picking, the body owns its shape and motion state
 	class PickingBody
 	{
 	public:
-		PickingBody(RigidBodyType::ID id);
-		
-	public:
-		void DestroyBody();
-
-	public:
-		void SetTransform(glm::vec3 position, glm::vec3 scale, glm::quat orientation);
-
-	public:
-		btRigidBody* GetRigidBody() const;
-		RigidBodyType::ID GetPickingType() const;
-
-	private:
-		void CreateBody();
-
-	private:
-		btCollisionShape* m_shape;
-		btDefaultMotionState* m_motionState;
-		btRigidBody* m_rigidBody;
-		RigidBodyType::ID m_pickingType;
+		//Always creates the body at the origin because of the local scaling problem associated with the
+		//collision shape, SetTransform() has to be called afterwards
+		static btRigidBody* Create(RigidBodyType::ID type);
+		static void Destroy(btRigidBody* body);
+		static void SetTransform(btRigidBody* body, glm::vec3 position, glm::vec3 scale, glm::quat orientation);
 	};
 }
-
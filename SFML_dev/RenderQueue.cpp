@@ -0,0 +1,177 @@
+#include "RenderQueue.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace px
+{
+	//Key layout from the most significant bit:
+	//Opaque:      layer(2) | shader(6) | model(12) | mesh(8) | lod(2) | material(10) | depth(24)
+	//Transparent: layer(2) | inverted depth(24) | shader(6) | model(12) | mesh(8) | lod(2) | material(10)
+	namespace
+	{
+		const unsigned int LAYER_BITS = 2;
+		const unsigned int SHADER_BITS = 6;
+		const unsigned int MODEL_BITS = 12;
+		const unsigned int MESH_BITS = 8;
+		const unsigned int LOD_BITS = 2;
+		const unsigned int MATERIAL_BITS = 10;
+		const unsigned int DEPTH_BITS = 24;
+
+		const unsigned int STATE_BITS = SHADER_BITS + MODEL_BITS + MESH_BITS + LOD_BITS + MATERIAL_BITS;
+
+		inline std::uint64_t Field(std::uint64_t value, unsigned int bits)
+		{
+			return value & ((std::uint64_t(1) << bits) - 1);
+		}
+
+		inline std::uint64_t QuantizeDepth(float depth)
+		{
+			//Depth is expected in [0, 1]
+			float clamped = std::min(std::max(depth, 0.f), 1.f);
+			return (std::uint64_t)(clamped * (float)((1 << DEPTH_BITS) - 1));
+		}
+
+		inline std::uint64_t StateBits(const DrawPacket & packet)
+		{
+			std::uint64_t state = Field(packet.shader, SHADER_BITS);
+			state = (state << MODEL_BITS) | Field(packet.model.index, MODEL_BITS);
+			state = (state << MESH_BITS) | Field(packet.mesh, MESH_BITS);
+			state = (state << LOD_BITS) | Field(packet.lod, LOD_BITS);
+			state = (state << MATERIAL_BITS) | Field(packet.material, MATERIAL_BITS);
+			return state;
+		}
+	}
+
+	RenderQueue::RenderQueue()
+	{
+		std::memset(&m_statistics, 0, sizeof(Statistics));
+	}
+
+	void RenderQueue::Clear()
+	{
+		m_packets.clear();
+		m_entries.clear();
+	}
+
+	void RenderQueue::Push(const DrawPacket & packet)
+	{
+		SortEntry entry;
+		entry.key = MakeKey(packet);
+		entry.packet = (std::uint32_t)m_packets.size();
+
+		m_packets.push_back(packet);
+		m_entries.push_back(entry);
+	}
+
+	void RenderQueue::Sort()
+	{
+		RadixSort();
+		GatherStatistics();
+	}
+
+	std::uint64_t RenderQueue::MakeKey(const DrawPacket & packet)
+	{
+		std::uint64_t layer = Field(packet.layer, LAYER_BITS) << (64 - LAYER_BITS);
+		std::uint64_t depth = QuantizeDepth(packet.depth);
+
+		if (packet.layer == RenderLayers::Transparent)
+		{
+			//Back-to-front first, state second
+			std::uint64_t inverted = Field(~depth, DEPTH_BITS);
+			return layer | (inverted << STATE_BITS) | StateBits(packet);
+		}
+
+		//Group by state, then front-to-back inside each state bucket
+		return layer | (StateBits(packet) << DEPTH_BITS) | depth;
+	}
+
+	const DrawPacket & RenderQueue::GetPacket(std::size_t sortedIndex) const
+	{
+		return m_packets[m_entries[sortedIndex].packet];
+	}
+
+	std::size_t RenderQueue::GetSize() const
+	{
+		return m_entries.size();
+	}
+
+	const RenderQueue::Statistics & RenderQueue::GetStatistics() const
+	{
+		return m_statistics;
+	}
+
+	void RenderQueue::RadixSort()
+	{
+		//LSD radix sort, 8 passes over bytes. All histograms are built in a single sweep
+		std::size_t count = m_entries.size();
+		if (count < 2)
+			return;
+
+		std::uint32_t histograms[8][256];
+		std::memset(histograms, 0, sizeof(histograms));
+
+		for (const SortEntry & entry : m_entries)
+		{
+			for (unsigned int pass = 0; pass < 8; pass++)
+				histograms[pass][(entry.key >> (pass * 8)) & 0xFF]++;
+		}
+
+		m_scratch.resize(count);
+		SortEntry* source = m_entries.data();
+		SortEntry* destination = m_scratch.data();
+
+		for (unsigned int pass = 0; pass < 8; pass++)
+		{
+			std::uint32_t* histogram = histograms[pass];
+			unsigned int shift = pass * 8;
+
+			//Every key shares this byte, nothing to reorder
+			if (histogram[(source[0].key >> shift) & 0xFF] == count)
+				continue;
+
+			std::uint32_t offset = 0;
+			for (unsigned int i = 0; i < 256; i++)
+			{
+				std::uint32_t bucket = histogram[i];
+				histogram[i] = offset;
+				offset += bucket;
+			}
+
+			for (std::size_t i = 0; i < count; i++)
+				destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+
+			std::swap(source, destination);
+		}
+
+		if (source != m_entries.data())
+			m_entries.swap(m_scratch);
+	}
+
+	void RenderQueue::GatherStatistics()
+	{
+		std::memset(&m_statistics, 0, sizeof(Statistics));
+		m_statistics.packets = (unsigned int)m_entries.size();
+
+		const DrawPacket* previous = nullptr;
+		for (std::size_t i = 0; i < m_entries.size(); i++)
+		{
+			const DrawPacket & packet = GetPacket(i);
+
+			bool shaderChanged = !previous || previous->shader != packet.shader;
+			bool meshChanged = shaderChanged || previous->model != packet.model || previous->mesh != packet.mesh || previous->lod != packet.lod;
+
+			if (shaderChanged)
+				m_statistics.shaderChanges++;
+			if (meshChanged)
+				m_statistics.meshChanges++;
+			if (meshChanged || previous->material != packet.material)
+				m_statistics.materialChanges++;
+
+			//A new draw starts whenever the mesh changes or transparent draws interleave
+			if (meshChanged || previous->layer != packet.layer)
+				m_statistics.drawCalls++;
+
+			previous = &packet;
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "Shader.hpp"
+#include "ResourceIdentifiers.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace px
+{
+	//Layers are submitted in order, opaque draws go front-to-back and transparent ones back-to-front
+	namespace RenderLayers
+	{
+		enum ID
+		{
+			Opaque,
+			Transparent
+		};
+	}
+
+	//Everything needed to issue one (instanced) draw for one mesh of one entity
+	struct DrawPacket
+	{
+		RenderLayers::ID layer;
+		Shaders::ID shader;
+		ModelHandle model;
+		unsigned int mesh;
+		unsigned int lod;
+		unsigned int material;
+		float depth;
+		unsigned int instance;
+	};
+
+	class RenderQueue
+	{
+	public:
+		//State changes implied by the sorted order, gathered once per frame
+		struct Statistics
+		{
+			unsigned int packets;
+			unsigned int drawCalls;
+			unsigned int shaderChanges;
+			unsigned int meshChanges;
+			unsigned int materialChanges;
+		};
+
+	public:
+		RenderQueue();
+
+	public:
+		void Clear();
+		void Push(const DrawPacket & packet);
+		void Sort();
+
+	public:
+		static std::uint64_t MakeKey(const DrawPacket & packet);
+
+	public:
+		const DrawPacket & GetPacket(std::size_t sortedIndex) const;
+		std::size_t GetSize() const;
+		const Statistics & GetStatistics() const;
+
+	private:
+		void RadixSort();
+		void GatherStatistics();
+
+	private:
+		struct SortEntry
+		{
+			std::uint64_t key;
+			std::uint32_t packet;
+		};
+
+	private:
+		std::vector<DrawPacket> m_packets;
+		std::vector<SortEntry> m_entries;
+		std::vector<SortEntry> m_scratch;
+		Statistics m_statistics;
+	};
+}
@@ -1,11 +1,32 @@
 #include "RenderSystem.hpp"
 #include "Renderable.hpp"
 #include "Transformable.hpp"
+#include "Camera.hpp"
+#include "JobSystem.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace px
 {
-	RenderSystem::RenderSystem()
+	namespace
 	{
+		//Projected radius, as a fraction of half the viewport height, below which each coarser LOD kicks in
+		const float LOD_SCREEN_SIZES[MAX_MESH_LODS - 1] = { 0.25f, 0.12f, 0.05f };
+
+		//Switching back to a finer LOD needs this much more screen size than switching away from it, stops popping at the boundary
+		const float LOD_HYSTERESIS = 0.15f;
+
+		//Objects per culling and LOD job, scenes smaller than this stay on the calling thread
+		const std::size_t OBJECTS_PER_JOB = 512;
+	}
+
+	RenderSystem::RenderSystem(ModelHolder models, std::shared_ptr<Camera> camera, const TransformStore & transforms) : m_camera(camera), m_models(models),
+																						m_transforms(transforms), m_instanceOffset(0),
+																						m_instanceStream("RenderSystem instances", 1024 * sizeof(InstanceData)),
+																						m_indirectStream("RenderSystem indirect commands", 256 * sizeof(DrawElementsIndirectCommand))
+	{
+		std::memset(&m_statistics, 0, sizeof(Statistics));
 	}
 
 	RenderSystem::~RenderSystem()
@@ -13,15 +34,281 @@ namespace px
 	}
 
 	void RenderSystem::update(EntityManager & es, EventManager & events, TimeDelta dt)
+	{
+		CullObjects(es);
+		SelectLods();
+		CollectPackets();
+		m_queue.Sort();
+
+		m_instanceStream.BeginFrame();
+		m_indirectStream.BeginFrame();
+
+		UploadInstances();
+		Submit();
+
+		m_instanceStream.EndFrame();
+		m_indirectStream.EndFrame();
+
+		m_statistics.queue = m_queue.GetStatistics();
+	}
+
+	const RenderSystem::Statistics & RenderSystem::GetStatistics() const
+	{
+		return m_statistics;
+	}
+
+	void RenderSystem::CullObjects(EntityManager & es)
 	{
 		ComponentHandle<Transformable> transform;
 		ComponentHandle<Renderable> renderable;
 
+		m_objects.clear();
+		m_worlds.clear();
+		m_normals.clear();
+		m_sphereX.clear(); m_sphereY.clear(); m_sphereZ.clear(); m_sphereRadius.clear();
+
+		//Gather world matrices, walking the component pools has to happen on one thread
 		for (Entity entity : es.entities_with_components(transform, renderable))
 		{
-			Shader::SetMatrix4x4(renderable->object->GetShader(), "model", transform->transform->GetTransform());
-			renderable->object->Draw();
-			transform->transform->SetIdentity();
+			Object object;
+			object.renderable = renderable.get();
+			object.shader = renderable->shader;
+			object.model = renderable->model;
+			object.lod = renderable->lod;
+
+			m_objects.push_back(object);
+			m_worlds.push_back(m_transforms.GetWorld(transform->id));
+			m_normals.push_back(m_transforms.GetNormal(transform->id));
+		}
+
+		std::size_t count = m_objects.size();
+		m_sphereX.resize(count); m_sphereY.resize(count); m_sphereZ.resize(count); m_sphereRadius.resize(count);
+		m_visible.resize(count);
+		m_frustum.Extract(m_camera->GetProjectionMatrix() * m_camera->GetViewMatrix());
+
+		//World space bounding spheres, then each range is tested against the frustum in one batched pass
+		JobSystem::ParallelFor(count, OBJECTS_PER_JOB, [this](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t i = begin; i < end; i++)
+			{
+				BoundingSphere sphere = m_models->GetBoundingSphere(m_objects[i].model).Transform(m_worlds[i]);
+				m_sphereX[i] = sphere.center.x;
+				m_sphereY[i] = sphere.center.y;
+				m_sphereZ[i] = sphere.center.z;
+				m_sphereRadius[i] = sphere.radius;
+			}
+
+			m_frustum.CullSpheres(m_sphereX.data() + begin, m_sphereY.data() + begin, m_sphereZ.data() + begin, m_sphereRadius.data() + begin,
+				end - begin, m_visible.data() + begin);
+		});
+
+		m_statistics.objects = (unsigned int)m_objects.size();
+		m_statistics.culled = 0;
+		for (std::uint8_t visible : m_visible)
+			m_statistics.culled += visible ? 0 : 1;
+	}
+
+	void RenderSystem::SelectLods()
+	{
+		std::memset(m_statistics.lods, 0, sizeof(m_statistics.lods));
+
+		glm::vec3 eye = m_camera->GetPosition();
+		float projection = 1.f / std::tan(glm::radians(m_camera->GetFov()) * 0.5f);
+
+		JobSystem::ParallelFor(m_objects.size(), OBJECTS_PER_JOB, [this, eye, projection](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t i = begin; i < end; i++)
+			{
+				if (!m_visible[i])
+					continue;
+
+				//Projected size of the bounding sphere, anything the camera is inside of gets full detail
+				Object & object = m_objects[i];
+				float distance = glm::length(glm::vec3(m_sphereX[i], m_sphereY[i], m_sphereZ[i]) - eye);
+				float size = (distance > m_sphereRadius[i]) ? m_sphereRadius[i] * projection / distance : 1.f;
+
+				unsigned int lod = 0;
+				while (lod < MAX_MESH_LODS - 1)
+				{
+					float threshold = LOD_SCREEN_SIZES[lod] * (object.lod > lod ? 1.f + LOD_HYSTERESIS : 1.f - LOD_HYSTERESIS);
+					if (size >= threshold)
+						break;
+					lod++;
+				}
+
+				object.lod = lod;
+				object.renderable->lod = lod;
+			}
+		});
+
+		for (unsigned int i = 0; i < m_objects.size(); i++)
+		{
+			if (m_visible[i])
+				m_statistics.lods[m_objects[i].lod]++;
+		}
+	}
+
+	void RenderSystem::CollectPackets()
+	{
+		m_queue.Clear();
+
+		glm::vec3 eye = m_camera->GetPosition();
+		glm::vec3 front = m_camera->GetFront();
+
+		for (unsigned int instance = 0; instance < m_objects.size(); instance++)
+		{
+			if (!m_visible[instance])
+				continue;
+
+			//View depth of the object's origin, normalized over the camera range
+			glm::vec3 position = glm::vec3(m_worlds[instance][3]);
+			float depth = glm::dot(position - eye, front) / FAR_PLANE;
+
+			const Object & object = m_objects[instance];
+			const auto & meshes = m_models->GetMeshes(object.model);
+
+			for (unsigned int i = 0; i < meshes.size(); i++)
+			{
+				DrawPacket packet;
+				packet.layer = RenderLayers::Opaque;
+				packet.shader = object.shader;
+				packet.model = object.model;
+				packet.mesh = i;
+				packet.lod = std::min(object.lod, meshes[i]->GetLodCount() - 1);
+				packet.material = meshes[i]->GetMaterial();
+				packet.depth = depth;
+				packet.instance = instance;
+				m_queue.Push(packet);
+			}
+		}
+	}
+
+	void RenderSystem::UploadInstances()
+	{
+		//Instances are written in sorted order straight into the stream buffer so every draw reads one contiguous range
+		std::size_t count = m_queue.GetSize();
+		if (count == 0)
+			return;
+
+		InstanceData* instances = (InstanceData*)m_instanceStream.Map(count * sizeof(InstanceData), sizeof(InstanceData), m_instanceOffset);
+
+		ModelHandle model;
+		const std::vector<std::unique_ptr<Mesh>>* meshes = nullptr;
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			const DrawPacket & packet = m_queue.GetPacket(i);
+			if (packet.model != model)
+			{
+				model = packet.model;
+				meshes = &m_models->GetMeshes(model);
+			}
+
+			//Packed positions are relative to the mesh bounds, undoing that rides along with the world matrix
+			const Mesh & mesh = *(*meshes)[packet.mesh];
+			instances[i] = { m_worlds[packet.instance] * mesh.GetDequantization(), m_normals[packet.instance], mesh.GetColor() };
+		}
+
+		m_instanceStream.Unmap();
+	}
+
+	void RenderSystem::Submit()
+	{
+		//Consecutive packets sharing layer, shader, model, mesh and LOD become one indirect command,
+		//consecutive commands sharing a layer, shader and index type become one multi-draw
+		m_commands.clear();
+		m_batches.clear();
+		m_shortCommands.clear();
+		m_intCommands.clear();
+
+		std::size_t count = m_queue.GetSize();
+		std::size_t first = 0;
+
+		while (first < count)
+		{
+			const DrawPacket & packet = m_queue.GetPacket(first);
+			std::size_t last = first + 1;
+
+			while (last < count)
+			{
+				const DrawPacket & next = m_queue.GetPacket(last);
+				if (next.layer != packet.layer || next.shader != packet.shader || next.model != packet.model || next.mesh != packet.mesh || next.lod != packet.lod)
+					break;
+				last++;
+			}
+
+			if (first > 0)
+			{
+				const DrawPacket & previous = m_queue.GetPacket(first - 1);
+				if (previous.layer != packet.layer || previous.shader != packet.shader)
+					FlushCommands(previous.shader);
+			}
+
+			const GeometryRange & range = m_models->GetMeshes(packet.model)[packet.mesh]->GetRange();
+
+			DrawElementsIndirectCommand command;
+			command.count = range.indexCount[packet.lod];
+			command.instanceCount = (unsigned int)(last - first);
+			command.firstIndex = range.firstIndex[packet.lod];
+			command.baseVertex = (int)range.baseVertex;
+			command.baseInstance = (unsigned int)first;
+
+			//Opaque commands don't depend on each other's order, so splitting by index type within a shader is free.
+			//Transparent ones have to stay back-to-front, a change of index type ends the current multi-draw instead
+			if (packet.layer != RenderLayers::Opaque)
+			{
+				std::vector<DrawElementsIndirectCommand> & other = range.indexType == GL_UNSIGNED_SHORT ? m_intCommands : m_shortCommands;
+				if (!other.empty())
+					FlushCommands(packet.shader);
+			}
+
+			if (range.indexType == GL_UNSIGNED_SHORT)
+				m_shortCommands.push_back(command);
+			else
+				m_intCommands.push_back(command);
+
+			first = last;
+		}
+
+		if (count > 0)
+			FlushCommands(m_queue.GetPacket(count - 1).shader);
+
+		m_statistics.multiDraws = (unsigned int)m_batches.size();
+		if (m_commands.empty())
+			return;
+
+		std::size_t indirectOffset = m_indirectStream.Upload(m_commands.data(), m_commands.size() * sizeof(DrawElementsIndirectCommand), sizeof(DrawElementsIndirectCommand));
+
+		GeometryBuffer::Bind();
+		GeometryBuffer::BindInstances(m_instanceStream.GetBuffer(), m_instanceOffset);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectStream.GetBuffer());
+
+		for (auto & batch : m_batches)
+		{
+			Shader::Use(batch.shader);
+
+			const void* commands = (const void*)(indirectOffset + batch.firstCommand * sizeof(DrawElementsIndirectCommand));
+			glMultiDrawElementsIndirect(GL_TRIANGLES, batch.indexType, commands, (GLsizei)batch.commandCount, 0);
+		}
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+
+	void RenderSystem::FlushCommands(Shaders::ID shader)
+	{
+		if (!m_shortCommands.empty())
+		{
+			m_batches.push_back({ shader, GL_UNSIGNED_SHORT, (unsigned int)m_commands.size(), (unsigned int)m_shortCommands.size() });
+			m_commands.insert(m_commands.end(), m_shortCommands.begin(), m_shortCommands.end());
+			m_shortCommands.clear();
+		}
+
+		if (!m_intCommands.empty())
+		{
+			m_batches.push_back({ shader, GL_UNSIGNED_INT, (unsigned int)m_commands.size(), (unsigned int)m_intCommands.size() });
+			m_commands.insert(m_commands.end(), m_intCommands.begin(), m_intCommands.end());
+			m_intCommands.clear();
 		}
 	}
 }
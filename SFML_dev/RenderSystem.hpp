@@ -1,18 +1,86 @@
 #pragma once
 
 #include <entityx\entityx.h>
+#include "Model.hpp"
+#include "RenderQueue.hpp"
+#include "Frustum.hpp"
+#include "StreamBuffer.hpp"
+#include "ResourceIdentifiers.hpp"
 
 using namespace entityx;
 
 namespace px
 {
+	class Camera;
+	class TransformStore;
+	struct Renderable;
+
 	class RenderSystem : public System<RenderSystem>
 	{
 	public:
-		explicit RenderSystem();
+		struct Statistics
+		{
+			unsigned int objects;
+			unsigned int culled;
+			unsigned int multiDraws;
+			unsigned int lods[MAX_MESH_LODS];
+			RenderQueue::Statistics queue;
+		};
+
+	public:
+		RenderSystem(ModelHolder models, std::shared_ptr<Camera> camera, const TransformStore & transforms);
 		~RenderSystem();
 
 	public:
 		void update(EntityManager &es, EventManager &events, TimeDelta dt) override;
+
+	public:
+		const Statistics & GetStatistics() const;
+
+	private:
+		void CullObjects(EntityManager & es);
+		void SelectLods();
+		void CollectPackets();
+		void UploadInstances();
+		void Submit();
+		void FlushCommands(Shaders::ID shader);
+
+	private:
+		//Per-object data for the frame, the bounding spheres are kept as structure-of-arrays for the culling pass
+		struct Object
+		{
+			Renderable* renderable;
+			Shaders::ID shader;
+			ModelHandle model;
+			unsigned int lod;
+		};
+
+		//Commands submitted by one glMultiDrawElementsIndirect call
+		struct Batch
+		{
+			Shaders::ID shader;
+			GLenum indexType;
+			unsigned int firstCommand;
+			unsigned int commandCount;
+		};
+
+		RenderQueue m_queue;
+		Frustum m_frustum;
+		Statistics m_statistics;
+		std::vector<Object> m_objects;
+		std::vector<glm::mat4> m_worlds;
+		std::vector<glm::mat3> m_normals;
+		std::vector<float> m_sphereX, m_sphereY, m_sphereZ, m_sphereRadius;
+		std::vector<std::uint8_t> m_visible;
+		std::vector<DrawElementsIndirectCommand> m_commands;
+		std::vector<DrawElementsIndirectCommand> m_shortCommands;
+		std::vector<DrawElementsIndirectCommand> m_intCommands;
+		std::vector<Batch> m_batches;
+		std::shared_ptr<Camera> m_camera;
+		ModelHolder m_models;
+		const TransformStore & m_transforms;
+		std::size_t m_instanceOffset;
+		StreamBuffer m_instanceStream;
+		StreamBuffer m_indirectStream;
 	};
 }
@@ -1,5 +1,6 @@
 #include "RenderTexture.hpp"
 #include "Camera.hpp"
+#include "GpuMemory.hpp"
 #include <iostream>
 
 namespace px
@@ -35,6 +36,7 @@ namespace px
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, m_texture);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_width, m_height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+		GpuMemory::Resize(GpuResources::Texture, m_texture, GpuMemory::GetTextureBytes(GL_RGB, m_width, m_height));
 
 		glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
 	}
@@ -62,11 +64,13 @@ namespace px
 		//Create 4x MSAA framebuffer object
 		glGenFramebuffers(1, &m_framebuffer);
 		glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		GpuMemory::Register(GpuResources::Framebuffer, m_framebuffer, 0, "RenderTexture MSAA");
 
 		//Create multisampled texture
 		glGenTextures(1, &m_multiSampleTexture);
 		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_multiSampleTexture);
 		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGB, WINDOW_WIDTH, WINDOW_HEIGHT, GL_TRUE);
+		GpuMemory::Register(GpuResources::Texture, m_multiSampleTexture, GpuMemory::GetTextureBytes(GL_RGB, WINDOW_WIDTH, WINDOW_HEIGHT, 1, 1, 4), "RenderTexture MSAA color");
 		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, m_multiSampleTexture, 0);
 
@@ -74,6 +78,7 @@ namespace px
 		glGenRenderbuffers(1, &m_colorBuffer);
 		glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
 		glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH24_STENCIL8, WINDOW_WIDTH, WINDOW_HEIGHT);
+		GpuMemory::Register(GpuResources::Renderbuffer, m_colorBuffer, GpuMemory::GetTextureBytes(GL_DEPTH24_STENCIL8, WINDOW_WIDTH, WINDOW_HEIGHT, 1, 1, 4), "RenderTexture MSAA depth");
 		glBindRenderbuffer(GL_RENDERBUFFER, 0);
 		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_colorBuffer);
 
@@ -84,11 +89,13 @@ namespace px
 		//Now create another framebuffer which we can transfer the MSAA one to
 		glGenFramebuffers(1, &m_intermediateFBO);
 		glBindFramebuffer(GL_FRAMEBUFFER, m_intermediateFBO);
+		GpuMemory::Register(GpuResources::Framebuffer, m_intermediateFBO, 0, "RenderTexture resolve");
 
 		//Create color attachment texture
 		glGenTextures(1, &m_texture);
 		glBindTexture(GL_TEXTURE_2D, m_texture);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, WINDOW_WIDTH, WINDOW_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+		GpuMemory::Register(GpuResources::Texture, m_texture, GpuMemory::GetTextureBytes(GL_RGB, WINDOW_WIDTH, WINDOW_HEIGHT), "RenderTexture resolve color");
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0); //We only need a color buffer
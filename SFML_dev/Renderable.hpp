@@ -1,13 +1,21 @@
 #pragma once
-#include <memory>
-#include "Render.hpp"
+#include "Model.hpp"
+#include "NameTable.hpp"
+#include "ResourceIdentifiers.hpp"
 
 namespace px
 {
+	//Plain data stored by value in the entity pool. The scene acquires the model when the entity is created and
+	//releases it when it is destroyed, the name is interned in the scene's name table
 	struct Renderable
 	{
-		explicit Renderable(std::unique_ptr<Render> & object) : object(std::move(object)) {}
+		Renderable(ModelHandle model, Shaders::ID shader, NameID name) : model(model), shader(shader), name(name), lod(0) {}
 
-		std::unique_ptr<Render> object;
+		ModelHandle model;
+		Shaders::ID shader;
+		NameID name;
+
+		//Chosen by the render system, remembered for the hysteresis next frame
+		unsigned int lod;
 	};
 }
\ No newline at end of file
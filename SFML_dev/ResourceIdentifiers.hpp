@@ -1,4 +1,6 @@
 #pragma once
+#include "AssetRegistry.hpp"
+#include <memory>
 
 namespace px
 {
@@ -11,11 +13,25 @@ namespace px
 			Cylinder,
 			Capsule
 		};
+
+		//Built-in shapes, older scene files still refer to them by their ID
+		const char* const Paths[] =
+		{
+			"../res/Models/Cube/cube.obj",
+			"../res/Models/Sphere/sphere.obj",
+			"../res/Models/Cylinder/cylinder.obj",
+			"../res/Models/Capsule/capsule.obj"
+		};
 	}
 
 	//Forward declaration and a few type definitions
-	template <typename Identifier>
 	class Model;
+	struct ModelAsset;
+	class Texture;
+	struct TextureAsset;
 
-	typedef std::shared_ptr<Model<Models::ID>> ModelHolder;
+	typedef std::shared_ptr<Model> ModelHolder;
+	typedef AssetHandle<ModelAsset> ModelHandle;
+	typedef std::shared_ptr<Texture> TextureHolder;
+	typedef AssetHandle<TextureAsset> TextureHandle;
 }
@@ -2,6 +2,7 @@
 #include "Converters.hpp"
 #include <json.hpp>
 #include <fstream>
+#include <algorithm>
 
 using json = nlohmann::json;
 
@@ -9,15 +10,26 @@ using json = nlohmann::json;
 
 namespace px
 {
-	Scene::Scene() : m_entities(m_events), m_systems(m_entities, m_events)
+	namespace
 	{
+		//Smallest scale handed to Bullet, a zero scale collapses the shape's AABB
+		const float MIN_BODY_SCALE = 1e-4f;
 	}
 
-	void Scene::LoadScene(ModelHolder models)
+	Scene::Scene() : m_entities(m_events), m_systems(m_entities, m_events), m_transformUpdates(0)
+	{
+	}
+
+	void Scene::ReadScene()
 	{
 		//Read scene data from json file
 		std::ifstream i("Scripts/Json/scene.json");
-		json reader; i >> reader; i.close();
+		i >> m_sceneData; i.close();
+	}
+
+	void Scene::LoadScene(ModelHolder models)
+	{
+		json & reader = m_sceneData;
 
 		//Camera
 		if (reader["Camera"]["count"] == 1) //Prevent crash if the scene file doesn't have camera data
@@ -28,110 +40,151 @@ namespace px
 		else
 			m_camera = std::make_shared<Camera>();
 
-		//Physics
-		Physics::Init(m_camera);
-
-		//Entities
+		//Entities, scenes saved before models were addressed by path store the built-in model ID
+		m_models = models;
+		std::vector<Entity> loaded;
 		for (unsigned int i = 0; i < reader["Scene"]["count"]; i++)
 		{
 			std::string name = reader["Scene"]["names"][i];
+			const json & model = reader[name]["model"];
+			std::string modelPath = model.is_number() ? Models::Paths[model.get<int>()] : model.get<std::string>();
+
+			RigidBodyType::ID pickShape = reader[name]["pickingType"];
+			Entity entity = CreateEntity(modelPath, pickShape, name);
+			TransformID transform = entity.component<Transformable>()->id;
+			m_transforms.SetPosition(transform, utils::FromVec3Json(reader[name]["position"]));
+			m_transforms.SetRotationAngles(transform, utils::FromVec3Json(reader[name]["rotation"]));
+			m_transforms.SetScale(transform, utils::FromVec3Json(reader[name]["scale"]));
+			loaded.push_back(entity);
+		}
 
-			//Transform component
-			auto entity = m_entities.create();
-			auto transform = std::make_unique<Transform>();
-			transform->SetPosition(utils::FromVec3Json(reader[name]["position"]));
-			transform->SetRotationOnAllAxis(utils::FromVec3Json(reader[name]["rotation"]));
-			transform->SetScale(utils::FromVec3Json(reader[name]["scale"]));
-
-			//Picking component
-			RigidBodyType::ID id = reader[name]["pickingType"];
-			auto pickable = std::make_unique<px::PickingBody>(id);
-			pickable->SetTransform(utils::FromVec3Json(reader[name]["position"]), utils::FromVec3Json(reader[name]["scale"]),
-			transform->GetOrientation());
-
-			//Render component
-			auto render = std::make_unique<px::Render>(models, reader[name]["model"], Shaders::Phong, name);
-
-			entity.assign<Transformable>(transform);
-			entity.assign<Renderable>(render);
-			entity.assign<Pickable>(pickable);
+		//Parents are linked once every entity exists, the file can list children before their parents
+		for (unsigned int i = 0; i < loaded.size(); i++)
+		{
+			std::string name = reader["Scene"]["names"][i];
+			if (reader[name].count("parent"))
+				SetParent(loaded[i], GetEntityByName(reader[name]["parent"]));
 		}
 
 		//Systems
-		m_systems.add<RenderSystem>();
+		m_systems.add<RenderSystem>(models, m_camera, m_transforms);
 		m_systems.configure();
+
+		//Only needed while building
+		m_sceneData = json();
 	}
 
-	void Scene::ChangeEntityName(std::string name, std::string newName)
+	bool Scene::ChangeEntityName(const std::string & name, const std::string & newName)
 	{
-		ComponentHandle<Renderable> renderable;
+		Entity entity = GetEntityByName(name);
+		if (!entity.valid() || newName.empty() || IsNameTaken(newName))
+			return false;
 
-		//TODO: make sure that the chosen name doesn't already exist!
-		for (Entity & entity : m_entities.entities_with_components(renderable))
-		{
-			if (name == renderable->object->GetName())
-			{
-				renderable->object->SetName(newName);
-				break;
-			}
-		}
+		RemoveName(name);
+		entity.component<Renderable>()->name = IndexName(entity.id(), newName);
+
+		return true;
 	}
 
-	void Scene::CreateEntity(ModelHolder models, Models::ID modelID, RigidBodyType::ID pickShape, std::string name)
+	Entity Scene::CreateEntity(const std::string & modelPath, RigidBodyType::ID pickShape, const std::string & name)
 	{
-		//Create entity at the origin
-		auto entity = m_entities.create();
-		auto transform = std::make_unique<Transform>();
-		auto render = std::make_unique<px::Render>(models, modelID, Shaders::Phong, name); //One shader right now
-		auto pickable = std::make_unique<px::PickingBody>(pickShape);
+		std::string entityName = IsNameTaken(name) ? MakeUniqueName(name) : name;
+
+		//Create entity at the origin, the model reference is held until DestroyComponents()
+		Entity entity = m_entities.create();
+		NameID nameID = IndexName(entity.id(), entityName);
+
+		TransformID transform = m_transforms.Create();
+		if (transform >= m_transformEntities.size())
+			m_transformEntities.resize(transform + 1, Entity::INVALID);
+		m_transformEntities[transform] = entity.id();
 
 		entity.assign<Transformable>(transform);
-		entity.assign<Renderable>(render);
-		entity.assign<Pickable>(pickable);
+		entity.assign<Renderable>(m_models->Acquire(modelPath), Shaders::Phong, nameID); //One shader right now
+		entity.assign<Pickable>(PickingBody::Create(pickShape), pickShape);
+		entity.assign<Hierarchy>();
+
+		return entity;
 	}
 
-	void Scene::DestroyEntity(std::string name)
+	void Scene::DestroyEntity(const std::string & name)
 	{
-		ComponentHandle<Renderable> renderable;
-		ComponentHandle<Pickable> pickable;
-
 		//Remove entity which corresponds to the name
-		for (Entity & entity : m_entities.entities_with_components(renderable, pickable))
-		{
-			if (name == renderable->object->GetName())
-			{
-				pickable->object->DestroyBody();
-				m_entities.destroy(entity.id());
-				break;
-			}
-		}
+		Entity entity = GetEntityByName(name);
+		if (!entity.valid())
+			return;
+
+		//Children move up to the destroyed entity's parent and keep their local transforms
+		ComponentHandle<Hierarchy> hierarchy = entity.component<Hierarchy>();
+		Entity parent = hierarchy->parent != Entity::INVALID ? m_entities.get(hierarchy->parent) : Entity();
+		while (hierarchy->firstChild != Entity::INVALID)
+			SetParent(m_entities.get(hierarchy->firstChild), parent);
+		Unlink(entity);
+
+		DestroyComponents(entity);
+		RemoveName(name);
+		m_entities.destroy(entity.id());
+	}
+
+	bool Scene::SetParent(const std::string & name, const std::string & parentName)
+	{
+		Entity entity = GetEntityByName(name);
+		Entity parent = parentName.empty() ? Entity() : GetEntityByName(parentName);
+		if (!entity.valid() || (!parentName.empty() && !parent.valid()))
+			return false;
+
+		return SetParent(entity, parent);
+	}
+
+	std::string Scene::GetParentName(const std::string & name)
+	{
+		Entity entity = GetEntityByName(name);
+		if (!entity.valid())
+			return std::string();
+
+		Entity::Id parent = entity.component<Hierarchy>()->parent;
+		return parent != Entity::INVALID ? m_names.GetString(m_entities.component<Renderable>(parent)->name) : std::string();
+	}
+
+	std::string Scene::MakeUniqueName(const std::string & prefix)
+	{
+		//Counters only move forward, so a burst of creations never rescans the numbers it already handed out
+		unsigned int & counter = m_nameCounters[prefix];
+
+		std::string name = prefix + std::to_string(counter++);
+		while (IsNameTaken(name))
+			name = prefix + std::to_string(counter++);
+
+		return name;
 	}
 
 	void Scene::UpdatePickedEntity(std::string name, glm::vec3 & position, glm::vec3 & rotation, glm::vec3 & scale, glm::vec3 & color, bool & picked)
 	{
-		ComponentHandle<Transformable> transform;
-		ComponentHandle<Renderable> renderable;
-		ComponentHandle<Pickable> pickable;
+		Entity selected = picked ? GetEntityByName(name) : Entity();
+		if (!selected.valid())
+			return;
 
-		//Update entities transformation
-		for (Entity & entity : m_entities.entities_with_components(transform, renderable, pickable))
-		{
-			if (name == renderable->object->GetName() && picked)
-			{
-				//Apply changes from GUI to picked object
-				renderable->object->SetColor(color);
-				transform->transform->SetPosition(position);
-				transform->transform->SetRotationOnAllAxis(rotation);
-				transform->transform->SetScale(scale);
-				pickable->object->SetTransform(position, scale, transform->transform->GetOrientation());
-			}
-			else
-				transform->transform->SetTransform();
-		}
+		//Apply changes from GUI to picked object
+		ComponentHandle<Renderable> renderable = selected.component<Renderable>();
+		ComponentHandle<Transformable> transform = selected.component<Transformable>();
+
+		m_models->SetColor(renderable->model, color);
+
+		//The GUI writes its values back every frame, only an actual edit marks the transform as changed
+		TransformID id = transform->id;
+		if (m_transforms.GetPosition(id) == position && m_transforms.GetRotationAngles(id) == rotation && m_transforms.GetScale(id) == scale)
+			return;
+
+		m_transforms.SetPosition(id, position);
+		m_transforms.SetRotationAngles(id, rotation);
+		m_transforms.SetScale(id, scale);
 	}
 
 	void Scene::UpdateSystems(double dt)
 	{
+		//Only transforms changed since the last frame are recomposed
+		m_transformUpdates = m_transforms.Update();
+		UpdatePickingBodies();
 		m_systems.update<RenderSystem>(dt);
 	}
 
@@ -154,12 +207,17 @@ namespace px
 
 		for (Entity & entity : m_entities.entities_with_components(transform, renderable, pickable))
 		{
-			data["Scene"]["names"][i] = renderable->object->GetName();
-			data[renderable->object->GetName()]["pickingType"] = pickable->object->GetPickingType();
-			data[renderable->object->GetName()]["model"] = renderable->object->GetModel();
-			data[renderable->object->GetName()]["position"] = utils::ToVec3Json(transform->transform->GetPosition());
-			data[renderable->object->GetName()]["rotation"] = utils::ToVec3Json(transform->transform->GetRotationAngles());
-			data[renderable->object->GetName()]["scale"] = utils::ToVec3Json(transform->transform->GetScale());
+			const std::string & name = m_names.GetString(renderable->name);
+			data["Scene"]["names"][i] = name;
+			data[name]["pickingType"] = pickable->type;
+			data[name]["model"] = m_models->GetPath(renderable->model);
+			data[name]["position"] = utils::ToVec3Json(m_transforms.GetPosition(transform->id));
+			data[name]["rotation"] = utils::ToVec3Json(m_transforms.GetRotationAngles(transform->id));
+			data[name]["scale"] = utils::ToVec3Json(m_transforms.GetScale(transform->id));
+
+			std::string parent = GetParentName(name);
+			if (!parent.empty())
+				data[name]["parent"] = parent;
 			i++;
 		}
 
@@ -174,9 +232,13 @@ namespace px
 
 		for (Entity & entity : m_entities.entities_with_components(pickable))
 		{
-			pickable->object->DestroyBody();
+			DestroyComponents(entity);
 			entity.destroy();
 		}
+
+		m_nameIndex.clear();
+		m_nameCounters.clear();
+		m_transformEntities.clear();
 	}
 
 	std::shared_ptr<Camera> Scene::GetCamera()
@@ -194,16 +256,178 @@ namespace px
 		return m_entities;
 	}
 
-	Entity Scene::GetEntityByName(std::string name)
+	const RenderSystem::Statistics & Scene::GetRenderStatistics()
 	{
-		ComponentHandle<Renderable> renderable;
+		return m_systems.system<RenderSystem>()->GetStatistics();
+	}
+
+	TransformStore & Scene::GetTransforms()
+	{
+		return m_transforms;
+	}
+
+	const ModelHolder & Scene::GetModels() const
+	{
+		return m_models;
+	}
+
+	const std::string & Scene::GetName(NameID name) const
+	{
+		return m_names.GetString(name);
+	}
+
+	unsigned int Scene::GetTransformUpdates() const
+	{
+		return m_transformUpdates;
+	}
+
+	Entity Scene::GetEntityByName(const std::string & name)
+	{
+		NameID id = m_names.Find(name);
+		if (id == INVALID_NAME || id >= m_nameIndex.size() || !m_entities.valid(m_nameIndex[id]))
+			return Entity();
+
+		return m_entities.get(m_nameIndex[id]);
+	}
+
+	bool Scene::IsNameTaken(const std::string & name) const
+	{
+		NameID id = m_names.Find(name);
+		return id != INVALID_NAME && id < m_nameIndex.size() && m_nameIndex[id] != Entity::INVALID;
+	}
+
+	NameID Scene::IndexName(Entity::Id entity, const std::string & name)
+	{
+		NameID id = m_names.Intern(name);
+		if (id >= m_nameIndex.size())
+			m_nameIndex.resize(id + 1, Entity::INVALID);
 
-		for (Entity & entity : m_entities.entities_with_components(renderable))
+		m_nameIndex[id] = entity;
+		return id;
+	}
+
+	void Scene::RemoveName(const std::string & name)
+	{
+		NameID id = m_names.Find(name);
+		if (id != INVALID_NAME && id < m_nameIndex.size())
+			m_nameIndex[id] = Entity::INVALID;
+	}
+
+	bool Scene::SetParent(Entity entity, Entity parent)
+	{
+		//An entity can't end up below itself
+		for (Entity::Id ancestor = parent.valid() ? parent.id() : Entity::INVALID; ancestor != Entity::INVALID;
+			 ancestor = m_entities.component<Hierarchy>(ancestor)->parent)
 		{
-			if (name == renderable->object->GetName())
-				return entity;
+			if (ancestor == entity.id())
+				return false;
 		}
 
-		return Entity();
+		Unlink(entity);
+
+		TransformID parentTransform = INVALID_TRANSFORM;
+		if (parent.valid())
+		{
+			//Appended so children stay in the order they were attached
+			ComponentHandle<Hierarchy> hierarchy = entity.component<Hierarchy>();
+			ComponentHandle<Hierarchy> parentHierarchy = parent.component<Hierarchy>();
+			hierarchy->parent = parent.id();
+
+			if (parentHierarchy->firstChild == Entity::INVALID)
+				parentHierarchy->firstChild = entity.id();
+			else
+			{
+				Entity::Id last = parentHierarchy->firstChild;
+				while (m_entities.component<Hierarchy>(last)->nextSibling != Entity::INVALID)
+					last = m_entities.component<Hierarchy>(last)->nextSibling;
+
+				m_entities.component<Hierarchy>(last)->nextSibling = entity.id();
+				hierarchy->previousSibling = last;
+			}
+
+			parentTransform = parent.component<Transformable>()->id;
+		}
+
+		m_transforms.SetParent(entity.component<Transformable>()->id, parentTransform);
+		return true;
+	}
+
+	void Scene::Unlink(Entity entity)
+	{
+		ComponentHandle<Hierarchy> hierarchy = entity.component<Hierarchy>();
+		if (hierarchy->parent == Entity::INVALID)
+			return;
+
+		if (hierarchy->previousSibling != Entity::INVALID)
+			m_entities.component<Hierarchy>(hierarchy->previousSibling)->nextSibling = hierarchy->nextSibling;
+		else
+			m_entities.component<Hierarchy>(hierarchy->parent)->firstChild = hierarchy->nextSibling;
+
+		if (hierarchy->nextSibling != Entity::INVALID)
+			m_entities.component<Hierarchy>(hierarchy->nextSibling)->previousSibling = hierarchy->previousSibling;
+
+		hierarchy->parent = hierarchy->previousSibling = hierarchy->nextSibling = Entity::INVALID;
+	}
+
+	void Scene::UpdatePickingBodies()
+	{
+		//Bodies follow the world matrices, so moving a parent drags the bodies of its children along. Shear from a
+		//non-uniform parent scale can't be represented by a body and is dropped
+		for (TransformID slot : m_transforms.GetChangedWorlds())
+		{
+			Entity::Id id = m_transformEntities[slot];
+			if (!m_entities.valid(id))
+				continue;
+
+			ComponentHandle<Pickable> pickable = m_entities.component<Pickable>(id);
+			if (!pickable)
+				continue;
+
+			const glm::mat4 & world = m_transforms.GetWorld(slot);
+			glm::mat3 rotation(world);
+			glm::vec3 scale;
+			for (int i = 0; i < 3; i++)
+			{
+				scale[i] = std::max(glm::length(rotation[i]), MIN_BODY_SCALE);
+				rotation[i] /= scale[i];
+			}
+
+			//A zero scale leaves no direction behind, the missing axis is rebuilt from the other two
+			for (int i = 0; i < 3; i++)
+			{
+				if (glm::length(rotation[i]) > 0.5f)
+					continue;
+
+				glm::vec3 axis = glm::cross(rotation[(i + 1) % 3], rotation[(i + 2) % 3]);
+				if (glm::length(axis) > 0.5f)
+					rotation[i] = glm::normalize(axis);
+				else
+					rotation = glm::mat3();
+			}
+
+			//Mirroring can't be a rotation, it goes into the scale of one axis instead
+			if (glm::determinant(rotation) < 0.f)
+			{
+				rotation[0] = -rotation[0];
+				scale.x = -scale.x;
+			}
+
+			PickingBody::SetTransform(pickable->body, glm::vec3(world[3]), scale, glm::quat_cast(rotation));
+		}
+	}
+
+	void Scene::DestroyComponents(Entity entity)
+	{
+		//The components only hold handles, what they refer to is given back here
+		ComponentHandle<Transformable> transform = entity.component<Transformable>();
+		ComponentHandle<Renderable> renderable = entity.component<Renderable>();
+		ComponentHandle<Pickable> pickable = entity.component<Pickable>();
+
+		if (transform)
+			m_transforms.Destroy(transform->id);
+		if (renderable)
+			m_models->Release(renderable->model);
+		if (pickable)
+			PickingBody::Destroy(pickable->body);
 	}
 }
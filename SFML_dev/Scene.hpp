@@ -2,9 +2,11 @@
 #define GLFW_INCLUDE_NONE
 #include <entityx\entityx.h>
 #include <memory>
+#include <json.hpp>
 #include "Camera.hpp"
 #include "Model.hpp"
 #include "ResourceIdentifiers.hpp"
+#include "NameTable.hpp"
 
 //Systems
 #include "RenderSystem.hpp"
@@ -13,6 +15,7 @@
 #include "Transformable.hpp"
 #include "Renderable.hpp"
 #include "Pickable.hpp"
+#include "Hierarchy.hpp"
 
 using namespace entityx;
 
@@ -24,10 +27,18 @@ namespace px
 		Scene();
 
 	public:
+		//Parsing has no GL or physics calls and can run on a worker, LoadScene then builds the entities from it
+		void ReadScene();
 		void LoadScene(ModelHolder models);
-		void ChangeEntityName(std::string name, std::string newName);
-		void CreateEntity(ModelHolder models, Models::ID modelID, RigidBodyType::ID pickShape, std::string name);
-		void DestroyEntity(std::string name);
+		//Fails when the new name is already taken by another entity
+		bool ChangeEntityName(const std::string & name, const std::string & newName);
+
+		//A name that is already taken gets a number appended
+		Entity CreateEntity(const std::string & modelPath, RigidBodyType::ID pickShape, const std::string & name);
+		void DestroyEntity(const std::string & name);
+		//An empty parent name makes the entity a root again, fails when the parent is the entity or one of its children
+		bool SetParent(const std::string & name, const std::string & parentName);
+		std::string MakeUniqueName(const std::string & prefix);
 		void UpdatePickedEntity(std::string name, glm::vec3 & position, glm::vec3 & rotation, glm::vec3 & scale, glm::vec3 & color, bool & picked);
 		void UpdateSystems(double dt);
 		void WriteSceneData();
@@ -37,15 +48,43 @@ namespace px
 		std::shared_ptr<Camera> GetCamera();
 		unsigned int GetEntityCount();
 		EntityManager & GetEntities();
-		Entity GetEntityByName(std::string name);
+		Entity GetEntityByName(const std::string & name);
+		bool IsNameTaken(const std::string & name) const;
+		std::string GetParentName(const std::string & name);
+		const RenderSystem::Statistics & GetRenderStatistics();
+		TransformStore & GetTransforms();
+		const ModelHolder & GetModels() const;
+		const std::string & GetName(NameID name) const;
+		unsigned int GetTransformUpdates() const;
 
 	private:
+		//Transformable components are slots in here
+		TransformStore m_transforms;
 		EntityManager m_entities;
 		EventManager m_events;
 		SystemManager m_systems;
 
+	private:
+		NameID IndexName(Entity::Id entity, const std::string & name);
+		void RemoveName(const std::string & name);
+		void DestroyComponents(Entity entity);
+		bool SetParent(Entity entity, Entity parent);
+		void Unlink(Entity entity);
+		void UpdatePickingBodies();
+
 	private:
 		std::shared_ptr<Camera> m_camera;
+		ModelHolder m_models;
+		nlohmann::json m_sceneData;
+
+		//Entity names are unique, the index is addressed by interned name and holds INVALID for names not in use
+		NameTable m_names;
+		std::vector<Entity::Id> m_nameIndex;
+		std::unordered_map<std::string, unsigned int> m_nameCounters;
+		unsigned int m_transformUpdates;
+
+		//Owner of every transform slot, so changed world matrices can be traced back to their entity
+		std::vector<Entity::Id> m_transformEntities;
 	};
 }
 
@@ -1,18 +1,133 @@
 #include "Shader.hpp"
+#include "MappedFile.hpp"
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <assert.h>
 
 namespace px
 {
+	namespace
+	{
+		const char PROGRAM_CACHE_MAGIC[4] = { 'P', 'X', 'P', 'G' };
+
+		//On-disk layout, the driver's binary follows right after
+		struct ProgramHeader
+		{
+			char magic[4];
+			std::uint32_t version;
+			std::uint64_t hash;
+			std::uint32_t format;
+			std::uint32_t size;
+			double compileTime;
+		};
+
+		static_assert(sizeof(ProgramHeader) == 32, "Program cache header layout changed");
+
+		typedef std::chrono::high_resolution_clock Clock;
+
+		std::uint64_t Fnv1a(std::uint64_t hash, const void* data, std::size_t size)
+		{
+			const unsigned char* bytes = (const unsigned char*)data;
+			for (std::size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+
+		std::uint64_t Fnv1a(std::uint64_t hash, const char* text)
+		{
+			//Terminator included so neighbouring strings can't run into each other
+			return text ? Fnv1a(hash, text, std::strlen(text) + 1) : Fnv1a(hash, "", 1);
+		}
+
+		std::string GetStem(const char* path)
+		{
+			std::string stem(path);
+			std::size_t slash = stem.find_last_of("/\\");
+			if (slash != std::string::npos)
+				stem.erase(0, slash + 1);
+
+			std::size_t dot = stem.find_last_of('.');
+			if (dot != std::string::npos)
+				stem.erase(dot);
+
+			return stem;
+		}
+	}
+
 	std::map<Shaders::ID, Shader::ShaderInfo> Shader::m_shaders;
+	std::vector<std::string> Shader::m_defines;
+	Shader::CacheStatistics Shader::m_cacheStatistics = {};
 
 	void Shader::LoadShaders(Shaders::ID id, const char * vertexPath, const char * fragmentPath)
 	{
-		CreateShader(id, vertexPath, GL_VERTEX_SHADER);
-		CreateShader(id, fragmentPath, GL_FRAGMENT_SHADER);
+		LoadShaders(id, ReadProgram(vertexPath, fragmentPath));
+	}
+
+	void Shader::LoadShaders(Shaders::ID id, const ProgramSource & source)
+	{
+		const char* vertexPath = source.vertexPath.c_str();
+		const char* fragmentPath = source.fragmentPath.c_str();
+
+		std::string vertexCode = source.vertexCode, fragmentCode = source.fragmentCode;
+		InsertDefines(vertexCode);
+		InsertDefines(fragmentCode);
 
+		std::uint64_t hash = HashProgram(vertexCode, fragmentCode);
+		std::string cachePath = GetCachePath(vertexPath, fragmentPath);
+
+		Clock::time_point start = Clock::now();
+		double compileTime = 0.0;
+
+		if (LoadProgramBinary(id, cachePath, hash, compileTime))
+		{
+			double loadTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			m_cacheStatistics.hits++;
+			m_cacheStatistics.loadTime += loadTime;
+			m_cacheStatistics.savedTime += std::max(compileTime - loadTime, 0.0);
+
+			ReflectUniforms(id);
+			return;
+		}
+
+		CreateShader(id, vertexCode, vertexPath, GL_VERTEX_SHADER);
+		CreateShader(id, fragmentCode, fragmentPath, GL_FRAGMENT_SHADER);
 		AttachShader(id);
+
+		compileTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		m_cacheStatistics.misses++;
+		m_cacheStatistics.compileTime += compileTime;
+
+		SaveProgramBinary(id, cachePath, hash, compileTime);
+	}
+
+	void Shader::AddDefine(const std::string & define)
+	{
+		//Applies to every shader loaded afterwards
+		m_defines.push_back(define);
+	}
+
+	ProgramSource Shader::ReadProgram(const char* vertexPath, const char* fragmentPath)
+	{
+		ProgramSource source;
+		source.vertexPath = vertexPath;
+		source.fragmentPath = fragmentPath;
+		source.vertexCode = ReadSource(vertexPath);
+		source.fragmentCode = ReadSource(fragmentPath);
+
+		return source;
+	}
+
+	const Shader::CacheStatistics & Shader::GetCacheStatistics()
+	{
+		return m_cacheStatistics;
 	}
 
 	void Shader::Use(Shaders::ID id)
@@ -20,7 +135,7 @@ namespace px
 		glUseProgram(m_shaders[id].id);
 	}
 
-	void Shader::CreateShader(Shaders::ID id, const char* path, GLenum shaderType)
+	std::string Shader::ReadSource(const char* path)
 	{
 		//Reader shader source
 		std::string code;
@@ -41,6 +156,38 @@ namespace px
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
 
+		return code;
+	}
+
+	void Shader::InsertDefines(std::string & code)
+	{
+		//Defines have to follow the #version line
+		if (!m_defines.empty())
+		{
+			std::string defines;
+			for (auto & define : m_defines)
+				defines += "#define " + define + "\n";
+
+			std::size_t version = code.find("#version");
+			std::size_t insertAt = 0;
+
+			if (version != std::string::npos)
+			{
+				insertAt = code.find('\n', version);
+				if (insertAt == std::string::npos)
+				{
+					code += '\n';
+					insertAt = code.size() - 1;
+				}
+				insertAt++;
+			}
+
+			code.insert(insertAt, defines);
+		}
+	}
+
+	void Shader::CreateShader(Shaders::ID id, const std::string & code, const char* path, GLenum shaderType)
+	{
 		//Compile shader
 		const char* vShaderCode = code.c_str();
 		unsigned int shader;
@@ -60,12 +207,150 @@ namespace px
 		for (auto shader : m_shaders[id].shaders)
 			glAttachShader(m_shaders[id].id, shader);
 
+		//Lets the driver keep the binary around for the cache
+		glProgramParameteri(m_shaders[id].id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 		glLinkProgram(m_shaders[id].id);
 		CheckCompileErrors(m_shaders[id].id, "PROGRAM");
 
 		//Done with shaders
 		for (auto shader : m_shaders[id].shaders)
 			glDeleteShader(shader);
+
+		m_shaders[id].shaders.clear();
+		ReflectUniforms(id);
+	}
+
+	bool Shader::LoadProgramBinary(Shaders::ID id, const std::string & cachePath, std::uint64_t hash, double & compileTime)
+	{
+		MappedFile file;
+		if (!file.Open(cachePath) || file.GetSize() < sizeof(ProgramHeader))
+			return false;
+
+		//Sources, defines or driver changed since it was written, the binary would be rejected anyway
+		const ProgramHeader* header = (const ProgramHeader*)file.GetData();
+		if (std::memcmp(header->magic, PROGRAM_CACHE_MAGIC, sizeof(header->magic)) != 0 || header->version != PROGRAM_CACHE_VERSION ||
+			header->hash != hash || sizeof(ProgramHeader) + header->size > file.GetSize())
+			return false;
+
+		unsigned int program = glCreateProgram();
+		glProgramBinary(program, header->format, file.GetData() + sizeof(ProgramHeader), header->size);
+
+		//Drivers may still refuse a binary with the same version string, then it is compiled as usual
+		int success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			glDeleteProgram(program);
+			return false;
+		}
+
+		m_shaders[id].id = program;
+		compileTime = header->compileTime;
+		return true;
+	}
+
+	void Shader::SaveProgramBinary(Shaders::ID id, const std::string & cachePath, std::uint64_t hash, double compileTime)
+	{
+		unsigned int program = m_shaders[id].id;
+
+		int success = 0, formats = 0, length = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		//Nothing to store for failed links or drivers without binary support
+		if (!success || formats == 0 || length <= 0)
+			return;
+
+		std::vector<char> binary(length);
+		GLenum format = GL_NONE;
+		GLsizei written = 0;
+		glGetProgramBinary(program, length, &written, &format, binary.data());
+
+		ProgramHeader header;
+		std::memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+		header.version = PROGRAM_CACHE_VERSION;
+		header.hash = hash;
+		header.format = format;
+		header.size = (std::uint32_t)written;
+		header.compileTime = compileTime;
+
+		std::ofstream output(cachePath, std::ios::binary | std::ios::trunc);
+		output.write((const char*)&header, sizeof(ProgramHeader));
+		output.write(binary.data(), written);
+
+		if (!output.good())
+			std::cout << "WARNING::SHADER:: Could not write " << cachePath << std::endl;
+	}
+
+	std::string Shader::GetCachePath(const char* vertexPath, const char* fragmentPath)
+	{
+		//One file per program, next to the sources
+		std::string vertex(vertexPath);
+		std::size_t slash = vertex.find_last_of("/\\");
+		std::string directory = slash == std::string::npos ? "" : vertex.substr(0, slash + 1);
+
+		std::string vertexStem = GetStem(vertexPath), fragmentStem = GetStem(fragmentPath);
+		std::string name = vertexStem == fragmentStem ? vertexStem : vertexStem + "_" + fragmentStem;
+
+		return directory + name + ".pxprog";
+	}
+
+	std::uint64_t Shader::HashProgram(const std::string & vertexCode, const std::string & fragmentCode)
+	{
+		//The defines are already part of the sources, the driver strings catch updates and GPU swaps
+		std::uint64_t hash = 14695981039346656037ull;
+		hash = Fnv1a(hash, vertexCode.c_str());
+		hash = Fnv1a(hash, fragmentCode.c_str());
+		hash = Fnv1a(hash, (const char*)glGetString(GL_VENDOR));
+		hash = Fnv1a(hash, (const char*)glGetString(GL_RENDERER));
+		hash = Fnv1a(hash, (const char*)glGetString(GL_VERSION));
+
+		return hash;
+	}
+
+	void Shader::ReflectUniforms(Shaders::ID id)
+	{
+		//Introspect the linked program once so setters never have to ask the driver
+		ShaderInfo & info = m_shaders[id];
+		info.uniforms.clear();
+
+		int count = 0, maxLength = 0;
+		glGetProgramiv(info.id, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(info.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+		std::vector<char> name(maxLength + 1);
+		for (int i = 0; i < count; i++)
+		{
+			UniformHandle handle;
+			int length = 0;
+			glGetActiveUniform(info.id, (GLuint)i, (GLsizei)name.size(), &length, &handle.size, &handle.type, name.data());
+
+			//Uniforms inside blocks have no location
+			handle.program = info.id;
+			handle.location = glGetUniformLocation(info.id, name.data());
+			if (handle.location < 0)
+				continue;
+
+			std::string uniformName(name.data(), length);
+			info.uniforms[uniformName] = handle;
+
+			//Arrays are reported as "name[0]", make them reachable by their plain name as well
+			std::size_t bracket = uniformName.find('[');
+			if (bracket != std::string::npos)
+				info.uniforms[uniformName.substr(0, bracket)] = handle;
+		}
+	}
+
+	int Shader::GetLocation(Shaders::ID id, const std::string & name)
+	{
+		const ShaderInfo & info = m_shaders[id];
+		auto found = info.uniforms.find(name);
+
+		if (found == info.uniforms.end())
+			return -1;
+
+		return found->second.location;
 	}
 
 	void Shader::CheckCompileErrors(unsigned int shader, std::string type)
@@ -94,43 +379,105 @@ namespace px
 
 	void Shader::SetBool(Shaders::ID id, const std::string & name, bool value)
 	{
-		glUniform1i(glGetUniformLocation(m_shaders[id].id, name.c_str()), (int)value);
+		glUniform1i(GetLocation(id, name), (int)value);
 	}
 
 	void Shader::SetInt(Shaders::ID id, const std::string & name, int value)
 	{
-		glUniform1i(glGetUniformLocation(m_shaders[id].id, name.c_str()), value);
+		glUniform1i(GetLocation(id, name), value);
 	}
 
 	void Shader::SetFloat(Shaders::ID id, const std::string & name, float value)
 	{
-		glUniform1f(glGetUniformLocation(m_shaders[id].id, name.c_str()), value);
+		glUniform1f(GetLocation(id, name), value);
 	}
 
 	void Shader::SetFloat2v(Shaders::ID id, const std::string & name, glm::vec2 vector)
 	{
-		glUniform2f(glGetUniformLocation(m_shaders[id].id, name.c_str()), vector.x, vector.y);
+		glUniform2f(GetLocation(id, name), vector.x, vector.y);
 	}
 
 	void Shader::SetFloat3v(Shaders::ID id, const std::string & name, glm::vec3 vector)
 	{
-		glUniform3f(glGetUniformLocation(m_shaders[id].id, name.c_str()), vector.x, vector.y, vector.z);
+		glUniform3f(GetLocation(id, name), vector.x, vector.y, vector.z);
 	}
 
 	void Shader::SetFloat4v(Shaders::ID id, const std::string & name, glm::vec4 vector)
 	{
-		glUniform4f(glGetUniformLocation(m_shaders[id].id, name.c_str()), vector.x, vector.y, vector.z, vector.w);
+		glUniform4f(GetLocation(id, name), vector.x, vector.y, vector.z, vector.w);
 	}
 
 	void Shader::SetMatrix3x3(Shaders::ID id, const std::string & name, glm::mat3 matrix)
 	{
-		unsigned int matrixLoc = glGetUniformLocation(m_shaders[id].id, name.c_str());
+		int matrixLoc = GetLocation(id, name);
 		glUniformMatrix3fv(matrixLoc, 1, GL_FALSE, glm::value_ptr(matrix));
 	}
 
 	void Shader::SetMatrix4x4(Shaders::ID id, const std::string & name, glm::mat4 matrix)
 	{
-		unsigned int matrixLoc = glGetUniformLocation(m_shaders[id].id, name.c_str());
+		int matrixLoc = GetLocation(id, name);
 		glUniformMatrix4fv(matrixLoc, 1, GL_FALSE, glm::value_ptr(matrix));
 	}
+
+	void Shader::SetBool(const UniformHandle & handle, bool value)
+	{
+		glProgramUniform1i(handle.program, handle.location, (int)value);
+	}
+
+	void Shader::SetInt(const UniformHandle & handle, int value)
+	{
+		glProgramUniform1i(handle.program, handle.location, value);
+	}
+
+	void Shader::SetFloat(const UniformHandle & handle, float value)
+	{
+		assert(handle.location < 0 || handle.type == GL_FLOAT);
+		glProgramUniform1f(handle.program, handle.location, value);
+	}
+
+	void Shader::SetFloat2v(const UniformHandle & handle, const glm::vec2 & vector)
+	{
+		assert(handle.location < 0 || handle.type == GL_FLOAT_VEC2);
+		glProgramUniform2fv(handle.program, handle.location, 1, glm::value_ptr(vector));
+	}
+
+	void Shader::SetFloat3v(const UniformHandle & handle, const glm::vec3 & vector)
+	{
+		assert(handle.location < 0 || handle.type == GL_FLOAT_VEC3);
+		glProgramUniform3fv(handle.program, handle.location, 1, glm::value_ptr(vector));
+	}
+
+	void Shader::SetFloat4v(const UniformHandle & handle, const glm::vec4 & vector)
+	{
+		assert(handle.location < 0 || handle.type == GL_FLOAT_VEC4);
+		glProgramUniform4fv(handle.program, handle.location, 1, glm::value_ptr(vector));
+	}
+
+	void Shader::SetMatrix3x3(const UniformHandle & handle, const glm::mat3 & matrix)
+	{
+		assert(handle.location < 0 || handle.type == GL_FLOAT_MAT3);
+		glProgramUniformMatrix3fv(handle.program, handle.location, 1, GL_FALSE, glm::value_ptr(matrix));
+	}
+
+	void Shader::SetMatrix4x4(const UniformHandle & handle, const glm::mat4 & matrix)
+	{
+		assert(handle.location < 0 || handle.type == GL_FLOAT_MAT4);
+		glProgramUniformMatrix4fv(handle.program, handle.location, 1, GL_FALSE, glm::value_ptr(matrix));
+	}
+
+	UniformHandle Shader::GetUniform(Shaders::ID id, const std::string & name)
+	{
+		//Unknown uniforms give an invalid handle which GL silently ignores, same as before
+		const ShaderInfo & info = m_shaders[id];
+		auto found = info.uniforms.find(name);
+
+		if (found == info.uniforms.end())
+		{
+			UniformHandle invalid;
+			invalid.program = info.id;
+			return invalid;
+		}
+
+		return found->second;
+	}
 }
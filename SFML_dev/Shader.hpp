@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <cstdint>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -22,10 +24,51 @@ namespace px
 		};
 	}
 
+	//Uniform location resolved once when the program is linked
+	struct UniformHandle
+	{
+		UniformHandle() : program(0), location(-1), type(GL_NONE), size(0) {}
+
+		unsigned int program;
+		int location;
+		GLenum type;
+		int size;
+	};
+
+	//Bump whenever the program cache layout changes
+	const std::uint32_t PROGRAM_CACHE_VERSION = 1;
+
+	//Sources of one program as read from disk, defines are only added when it is loaded
+	struct ProgramSource
+	{
+		std::string vertexPath;
+		std::string fragmentPath;
+		std::string vertexCode;
+		std::string fragmentCode;
+	};
+
 	class Shader
 	{
 	public:
+		//Program binary cache results since startup, saved time is the compile time recorded on the miss minus the load
+		struct CacheStatistics
+		{
+			unsigned int hits;
+			unsigned int misses;
+			double loadTime;
+			double compileTime;
+			double savedTime;
+		};
+
+	public:
+		//Links from the on-disk program binary when sources and driver still match, otherwise compiles and refreshes it
 		static void LoadShaders(Shaders::ID id, const char* vertexPath, const char* fragmentPath);
+		static void LoadShaders(Shaders::ID id, const ProgramSource & source);
+
+		//Only file reads, safe to call from any thread
+		static ProgramSource ReadProgram(const char* vertexPath, const char* fragmentPath);
+		static void AddDefine(const std::string & define);
+		static const CacheStatistics & GetCacheStatistics();
 
 	public:
 		static void Use(Shaders::ID id);
@@ -40,19 +83,44 @@ namespace px
 		static void SetMatrix3x3(Shaders::ID id, const std::string & name, glm::mat3 matrix);
 		static void SetMatrix4x4(Shaders::ID id, const std::string & name, glm::mat4 matrix);
 
+	public:
+		//Setters for hot paths, these never query the driver
+		static void SetBool(const UniformHandle & handle, bool value);
+		static void SetInt(const UniformHandle & handle, int value);
+		static void SetFloat(const UniformHandle & handle, float value);
+		static void SetFloat2v(const UniformHandle & handle, const glm::vec2 & vector);
+		static void SetFloat3v(const UniformHandle & handle, const glm::vec3 & vector);
+		static void SetFloat4v(const UniformHandle & handle, const glm::vec4 & vector);
+		static void SetMatrix3x3(const UniformHandle & handle, const glm::mat3 & matrix);
+		static void SetMatrix4x4(const UniformHandle & handle, const glm::mat4 & matrix);
+
+	public:
+		static UniformHandle GetUniform(Shaders::ID id, const std::string & name);
+
 	private:
-		static void CreateShader(Shaders::ID id, const char* path, GLenum shaderType);
+		static std::string ReadSource(const char* path);
+		static void InsertDefines(std::string & code);
+		static void CreateShader(Shaders::ID id, const std::string & code, const char* path, GLenum shaderType);
 		static void AttachShader(Shaders::ID id);
+		static bool LoadProgramBinary(Shaders::ID id, const std::string & cachePath, std::uint64_t hash, double & compileTime);
+		static void SaveProgramBinary(Shaders::ID id, const std::string & cachePath, std::uint64_t hash, double compileTime);
+		static std::string GetCachePath(const char* vertexPath, const char* fragmentPath);
+		static std::uint64_t HashProgram(const std::string & vertexCode, const std::string & fragmentCode);
 		static void CheckCompileErrors(unsigned int shader, std::string type);
+		static void ReflectUniforms(Shaders::ID id);
+		static int GetLocation(Shaders::ID id, const std::string & name);
 
 	private:
 		struct ShaderInfo
 		{
 			unsigned int id;
 			std::vector<unsigned int> shaders;
+			std::unordered_map<std::string, UniformHandle> uniforms;
 		};
 
 		static std::map<Shaders::ID, ShaderInfo> m_shaders;
+		static std::vector<std::string> m_defines;
+		static CacheStatistics m_cacheStatistics;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "StreamBuffer.hpp"
+#include "GpuMemory.hpp"
+#include <GLFW/glfw3.h>
+#include <cstring>
+#include <string>
+
+namespace px
+{
+	StreamBuffer::StreamBuffer(const std::string & owner, std::size_t frameSize, unsigned int framesInFlight) : m_buffer(0), m_region(0), m_framesInFlight(framesInFlight), 
+																					m_frameSize(frameSize), m_head(0), m_persistentData(nullptr),
+																					m_fences(framesInFlight, (GLsync)0), m_owner(owner)
+	{
+		m_persistent = SupportsBufferStorage();
+
+		GLint alignment = 1;
+		glGetIntegerv(GL_MIN_MAP_BUFFER_ALIGNMENT, &alignment);
+		m_mapAlignment = (std::size_t)alignment;
+
+		CreateBuffer();
+	}
+
+	StreamBuffer::~StreamBuffer()
+	{
+		DestroyBuffer();
+	}
+
+	void StreamBuffer::BeginFrame()
+	{
+		//Move on to the next region once the GPU is done with it
+		m_region = (m_region + 1) % m_framesInFlight;
+		WaitForRegion(m_region);
+		m_head = 0;
+	}
+
+	void StreamBuffer::EndFrame()
+	{
+		if (m_fences[m_region])
+			glDeleteSync(m_fences[m_region]);
+
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	void* StreamBuffer::Map(std::size_t size, std::size_t alignment, std::size_t & offset)
+	{
+		//Unsynchronized ranges have to start on the driver's map alignment
+		if (!m_persistent && alignment < m_mapAlignment)
+			alignment = m_mapAlignment;
+
+		std::size_t head = (m_head + alignment - 1) / alignment * alignment;
+		if (head + size > m_frameSize)
+		{
+			Grow(size + alignment);
+			head = 0;
+		}
+
+		m_head = head + size;
+		offset = m_region * m_frameSize + head;
+
+		if (m_persistent)
+			return m_persistentData + offset;
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+		return glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	}
+
+	void StreamBuffer::Unmap()
+	{
+		//Coherent mappings are visible to the GPU without any call
+		if (m_persistent)
+			return;
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	std::size_t StreamBuffer::Upload(const void * data, std::size_t size, std::size_t alignment)
+	{
+		std::size_t offset = 0;
+		void* destination = Map(size, alignment, offset);
+
+		std::memcpy(destination, data, size);
+		Unmap();
+
+		return offset;
+	}
+
+	unsigned int StreamBuffer::GetBuffer() const
+	{
+		return m_buffer;
+	}
+
+	bool StreamBuffer::IsPersistent() const
+	{
+		return m_persistent;
+	}
+
+	std::size_t StreamBuffer::GetFrameSize() const
+	{
+		return m_frameSize;
+	}
+
+	void StreamBuffer::CreateBuffer()
+	{
+		std::size_t totalSize = m_frameSize * m_framesInFlight;
+
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+
+		if (m_persistent)
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, NULL, flags);
+			m_persistentData = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags);
+		}
+		else
+			glBufferData(GL_COPY_WRITE_BUFFER, totalSize, NULL, GL_STREAM_DRAW);
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		GpuMemory::Register(GpuResources::Buffer, m_buffer, totalSize, m_owner);
+	}
+
+	void StreamBuffer::DestroyBuffer()
+	{
+		for (auto & fence : m_fences)
+		{
+			if (fence)
+				glDeleteSync(fence);
+			fence = 0;
+		}
+
+		if (m_persistent && m_persistentData)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			m_persistentData = nullptr;
+		}
+
+		GpuMemory::Unregister(GpuResources::Buffer, m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+	}
+
+	void StreamBuffer::Grow(std::size_t minimumSize)
+	{
+		//Draws already issued keep the old storage alive, the driver releases it once they retire
+		for (unsigned int i = 0; i < m_framesInFlight; i++)
+			WaitForRegion(i);
+
+		DestroyBuffer();
+		m_frameSize *= 2;
+		while (m_frameSize < minimumSize)
+			m_frameSize *= 2;
+
+		CreateBuffer();
+		m_head = 0;
+	}
+
+	void StreamBuffer::WaitForRegion(unsigned int region)
+	{
+		GLsync fence = m_fences[region];
+		if (!fence)
+			return;
+
+		//Flush on the first try so the fence is guaranteed to signal eventually
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		while (true)
+		{
+			GLenum result = glClientWaitSync(fence, flags, 1000000);
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+				break;
+			flags = 0;
+		}
+
+		glDeleteSync(fence);
+		m_fences[region] = 0;
+	}
+
+	bool StreamBuffer::SupportsBufferStorage()
+	{
+		//Core in 4.4, otherwise the extension has to be present and its entry point fetched by hand
+		if (GLAD_GL_VERSION_4_4 && glBufferStorage)
+			return true;
+
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+		for (GLint i = 0; i < count; i++)
+		{
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (extension && std::string(extension) == "GL_ARB_buffer_storage")
+			{
+				glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+				return glad_glBufferStorage != nullptr;
+			}
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace px
+{
+	//Ring of per-frame regions for dynamic data, each region is fenced so the CPU never overwrites data the GPU still reads.
+	//Uses a persistent coherent mapping when buffer storage is available and unsynchronized mapping otherwise
+	class StreamBuffer
+	{
+	public:
+		StreamBuffer(const std::string & owner, std::size_t frameSize, unsigned int framesInFlight = 3);
+		~StreamBuffer();
+
+	public:
+		void BeginFrame();
+		void EndFrame();
+
+	public:
+		//Returns a write pointer valid until Unmap(), offset receives the position inside GetBuffer()
+		void* Map(std::size_t size, std::size_t alignment, std::size_t & offset);
+		void Unmap();
+		std::size_t Upload(const void* data, std::size_t size, std::size_t alignment);
+
+	public:
+		unsigned int GetBuffer() const;
+		bool IsPersistent() const;
+		std::size_t GetFrameSize() const;
+
+	private:
+		void CreateBuffer();
+		void DestroyBuffer();
+		void Grow(std::size_t minimumSize);
+		void WaitForRegion(unsigned int region);
+
+	private:
+		static bool SupportsBufferStorage();
+
+	private:
+		unsigned int m_buffer;
+		unsigned int m_region;
+		unsigned int m_framesInFlight;
+		std::size_t m_frameSize;
+		std::size_t m_head;
+		std::size_t m_mapAlignment;
+		bool m_persistent;
+		char* m_persistentData;
+		std::vector<GLsync> m_fences;
+		std::string m_owner;
+	};
+}
@@ -0,0 +1,178 @@
+#include "TaskGraph.hpp"
+#include <json.hpp>
+#include <fstream>
+
+using json = nlohmann::json;
+
+namespace px
+{
+	TaskGraph::TaskGraph(std::shared_ptr<ThreadPool> threadPool) : m_threadPool(threadPool), m_finished(0), m_totalTime(0.0)
+	{
+	}
+
+	TaskGraph::TaskID TaskGraph::Add(const std::string & name, TaskThreads::ID thread, std::function<void()> work, const std::vector<TaskID> & dependencies)
+	{
+		TaskID id = (TaskID)m_tasks.size();
+
+		Task task;
+		task.work = std::move(work);
+		task.remaining = (unsigned int)dependencies.size();
+		m_tasks.push_back(std::move(task));
+
+		Timing timing;
+		timing.name = name;
+		timing.thread = thread;
+		timing.threadIndex = 0;
+		timing.start = 0.0;
+		timing.end = 0.0;
+		m_timings.push_back(timing);
+
+		for (TaskID dependency : dependencies)
+			m_tasks[dependency].dependents.push_back(id);
+
+		return id;
+	}
+
+	void TaskGraph::Run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_start = Clock::now();
+
+		//The calling thread is always thread 0 in the trace
+		m_threads[std::this_thread::get_id()] = 0;
+
+		for (TaskID task = 0; task < m_tasks.size(); task++)
+		{
+			if (m_tasks[task].remaining == 0)
+				Dispatch(task);
+		}
+
+		while (m_finished < m_tasks.size())
+		{
+			m_condition.wait(lock, [this] { return !m_mainReady.empty() || m_finished == m_tasks.size(); });
+
+			if (m_mainReady.empty())
+				break;
+
+			TaskID task = m_mainReady.front();
+			m_mainReady.pop_front();
+
+			lock.unlock();
+			Execute(task);
+			lock.lock();
+		}
+
+		m_totalTime = std::chrono::duration<double, std::milli>(Clock::now() - m_start).count();
+	}
+
+	bool TaskGraph::WriteTrace(const std::string & path) const
+	{
+		json events = json::array();
+
+		//Name the rows so the workers can be told apart from the context thread
+		unsigned int threadCount = (unsigned int)m_threads.size();
+		for (unsigned int i = 0; i < threadCount; i++)
+		{
+			json name;
+			name["name"] = "thread_name";
+			name["ph"] = "M";
+			name["pid"] = 1;
+			name["tid"] = i;
+			name["args"]["name"] = i == 0 ? std::string("Main") : "Worker " + std::to_string(i);
+			events.push_back(name);
+		}
+
+		for (const Timing & timing : m_timings)
+		{
+			json event;
+			event["name"] = timing.name;
+			event["cat"] = timing.thread == TaskThreads::Main ? "main" : "worker";
+			event["ph"] = "X";
+			event["pid"] = 1;
+			event["tid"] = timing.threadIndex;
+			event["ts"] = timing.start * 1000.0;
+			event["dur"] = (timing.end - timing.start) * 1000.0;
+			events.push_back(event);
+		}
+
+		json trace;
+		trace["traceEvents"] = events;
+		trace["displayTimeUnit"] = "ms";
+
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		file << trace.dump(1, '\t');
+		return file.good();
+	}
+
+	const std::vector<TaskGraph::Timing> & TaskGraph::GetTimings() const
+	{
+		return m_timings;
+	}
+
+	double TaskGraph::GetTotalTime() const
+	{
+		return m_totalTime;
+	}
+
+	double TaskGraph::GetSerialTime() const
+	{
+		//What the same tasks would take back to back on one thread
+		double time = 0.0;
+		for (const Timing & timing : m_timings)
+			time += timing.end - timing.start;
+
+		return time;
+	}
+
+	void TaskGraph::Dispatch(TaskID task)
+	{
+		//Called with the mutex held
+		if (m_timings[task].thread == TaskThreads::Main)
+		{
+			m_mainReady.push_back(task);
+			m_condition.notify_all();
+		}
+		else
+			m_threadPool->Enqueue([this, task] { Execute(task); });
+	}
+
+	void TaskGraph::Execute(TaskID task)
+	{
+		unsigned int threadIndex = GetThreadIndex();
+		Clock::time_point start = Clock::now();
+
+		m_tasks[task].work();
+
+		Clock::time_point end = Clock::now();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Timing & timing = m_timings[task];
+		timing.threadIndex = threadIndex;
+		timing.start = std::chrono::duration<double, std::milli>(start - m_start).count();
+		timing.end = std::chrono::duration<double, std::milli>(end - m_start).count();
+
+		for (TaskID dependent : m_tasks[task].dependents)
+		{
+			if (--m_tasks[dependent].remaining == 0)
+				Dispatch(dependent);
+		}
+
+		m_finished++;
+		m_condition.notify_all();
+	}
+
+	unsigned int TaskGraph::GetThreadIndex()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_threads.find(std::this_thread::get_id());
+		if (found != m_threads.end())
+			return found->second;
+
+		unsigned int index = (unsigned int)m_threads.size();
+		m_threads[std::this_thread::get_id()] = index;
+		return index;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace px
+{
+	//Main tasks run on the thread calling Run(), that is where everything touching the GL context goes
+	namespace TaskThreads
+	{
+		enum ID
+		{
+			Worker,
+			Main
+		};
+	}
+
+	//Runs a set of tasks once, each as soon as the tasks it depends on are done, and records when and where
+	//every task ran so the timeline can be inspected in chrome://tracing
+	class TaskGraph
+	{
+	public:
+		typedef unsigned int TaskID;
+
+		struct Timing
+		{
+			std::string name;
+			TaskThreads::ID thread;
+			unsigned int threadIndex;
+			double start;
+			double end;
+		};
+
+	public:
+		explicit TaskGraph(std::shared_ptr<ThreadPool> threadPool);
+
+		TaskGraph(const TaskGraph &) = delete;
+		TaskGraph & operator=(const TaskGraph &) = delete;
+
+	public:
+		//Dependencies have to be added first, which keeps the graph free of cycles
+		TaskID Add(const std::string & name, TaskThreads::ID thread, std::function<void()> work, const std::vector<TaskID> & dependencies = {});
+
+		//Blocks until every task has finished, running the main tasks in between
+		void Run();
+
+		//Chrome trace event format, times in microseconds from the start of Run()
+		bool WriteTrace(const std::string & path) const;
+
+	public:
+		const std::vector<Timing> & GetTimings() const;
+		double GetTotalTime() const;
+		double GetSerialTime() const;
+
+	private:
+		typedef std::chrono::high_resolution_clock Clock;
+
+		struct Task
+		{
+			std::function<void()> work;
+			std::vector<TaskID> dependents;
+			unsigned int remaining;
+		};
+
+	private:
+		void Dispatch(TaskID task);
+		void Execute(TaskID task);
+		unsigned int GetThreadIndex();
+
+	private:
+		std::shared_ptr<ThreadPool> m_threadPool;
+		std::vector<Task> m_tasks;
+		std::vector<Timing> m_timings;
+		std::deque<TaskID> m_mainReady;
+		std::map<std::thread::id, unsigned int> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		unsigned int m_finished;
+		Clock::time_point m_start;
+		double m_totalTime;
+	};
+}
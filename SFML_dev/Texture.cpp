@@ -0,0 +1,463 @@
+#include "Texture.hpp"
+#include "GpuMemory.hpp"
+#include "imgui_log.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace px
+{
+	namespace
+	{
+		//From EXT_texture_compression_s3tc, which the loader isn't generated with. BC5 is core as RGTC2
+		const GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+		const GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+
+		unsigned int GetMipSize(unsigned int size, unsigned int level)
+		{
+			return std::max(size >> level, 1u);
+		}
+	}
+
+	TextureArray::TextureArray(TextureFormats::ID format, unsigned int size, unsigned int layerCapacity) : m_format(format), m_size(size),
+																											m_mipCount(TextureCache::GetMipCount(size, size)),
+																											m_layerCapacity(layerCapacity)
+	{
+		glGenTextures(1, &m_texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_mipCount, Texture::GetInternalFormat(format), size, size, layerCapacity);
+		GpuMemory::Register(GpuResources::Texture, m_texture, GpuMemory::GetTextureBytes(Texture::GetInternalFormat(format), size, size, m_mipCount, layerCapacity),
+							std::string("TextureArray ") + TextureCache::GetFormatName(format) + " " + std::to_string(size));
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		//Hand out the lowest layers first
+		for (int layer = (int)layerCapacity - 1; layer >= 0; layer--)
+			m_freeLayers.push_back(layer);
+	}
+
+	TextureArray::~TextureArray()
+	{
+		GpuMemory::Unregister(GpuResources::Texture, m_texture);
+		glDeleteTextures(1, &m_texture);
+	}
+
+	bool TextureArray::Matches(const TextureView & texture) const
+	{
+		return texture.format == m_format && texture.width == m_size && texture.height == m_size && texture.mipCount == m_mipCount;
+	}
+
+	int TextureArray::AllocateLayer()
+	{
+		if (m_freeLayers.empty())
+			return -1;
+
+		int layer = m_freeLayers.back();
+		m_freeLayers.pop_back();
+		return layer;
+	}
+
+	void TextureArray::FreeLayer(int layer)
+	{
+		m_freeLayers.push_back(layer);
+	}
+
+	void TextureArray::UploadLevel(int layer, unsigned int level, const TextureView & texture)
+	{
+		unsigned int size = GetMipSize(m_size, level);
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+		if (m_format == TextureFormats::RGBA8)
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, texture.mips[level]);
+		else
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1, Texture::GetInternalFormat(m_format),
+									  (GLsizei)texture.mipSizes[level], texture.mips[level]);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	unsigned int TextureArray::GetTexture() const
+	{
+		return m_texture;
+	}
+
+	TextureFormats::ID TextureArray::GetFormat() const
+	{
+		return m_format;
+	}
+
+	unsigned int TextureArray::GetSize() const
+	{
+		return m_size;
+	}
+
+	unsigned int TextureArray::GetLayerCapacity() const
+	{
+		return m_layerCapacity;
+	}
+
+	unsigned int TextureArray::GetUsedLayers() const
+	{
+		return m_layerCapacity - (unsigned int)m_freeLayers.size();
+	}
+
+	Texture::Texture(std::shared_ptr<ThreadPool> threadPool) : m_threadPool(threadPool), m_queue(std::make_shared<LoadQueue>()), m_memoryBudget(TEXTURE_MEMORY_BUDGET),
+															   m_pendingLoads(0)
+	{
+		m_s3tc = SupportsS3TC();
+
+		//Bound in place of anything that isn't on the GPU yet
+		const std::uint8_t white[4] = { 255, 255, 255, 255 };
+		glGenTextures(1, &m_fallback);
+		glBindTexture(GL_TEXTURE_2D, m_fallback);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, 1, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+		GpuMemory::Register(GpuResources::Texture, m_fallback, sizeof(white), "Texture fallback");
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		m_upload.nextLevel = 0;
+		m_upload.uploadTime = 0.0;
+	}
+
+	TextureHandle Texture::Acquire(const std::string & path, TextureUsages::ID usage)
+	{
+		return StartLoad(path, usage, nullptr);
+	}
+
+	TextureHandle Texture::AcquireLayer(const std::string & path, std::shared_ptr<TextureArray> array, TextureUsages::ID usage)
+	{
+		return StartLoad(path, usage, array);
+	}
+
+	void Texture::AddReference(TextureHandle texture)
+	{
+		m_registry.AddReference(texture);
+	}
+
+	void Texture::Release(TextureHandle texture)
+	{
+		m_registry.Release(texture);
+	}
+
+	TextureHandle Texture::StartLoad(const std::string & path, TextureUsages::ID usage, std::shared_ptr<TextureArray> array)
+	{
+		//Every request for a path that is already loaded or loading shares the same texture
+		bool created = false;
+		TextureHandle texture = m_registry.Acquire(path, created);
+		if (!created)
+			return texture;
+
+		LoadResult* result = new LoadResult();
+		result->texture = texture;
+		result->path = path;
+		result->usage = usage;
+		result->compress = (usage == TextureUsages::Normal) || m_s3tc;
+		result->array = array;
+		result->cacheHit = false;
+		result->parseTime = 0.0;
+		result->requested = Clock::now();
+
+		std::shared_ptr<LoadQueue> queue = m_queue;
+		m_threadPool->Enqueue([result, queue]
+		{
+			RunLoad(*result);
+
+			std::lock_guard<std::mutex> lock(queue->mutex);
+			queue->finished.emplace_back(result);
+		});
+
+		m_pendingLoads++;
+		return texture;
+	}
+
+	void Texture::ProcessUploads()
+	{
+		m_registry.NextFrame();
+		std::size_t budget = TEXTURE_UPLOAD_BUDGET;
+
+		while (budget > 0)
+		{
+			if (!m_upload.result)
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_queue->mutex);
+					if (m_queue->finished.empty())
+						break;
+
+					m_upload.result = std::move(m_queue->finished.front());
+					m_queue->finished.pop_front();
+				}
+
+				if (!BeginUpload())
+					continue;
+			}
+
+			UploadLevels(budget);
+		}
+
+		unsigned int evicted = m_registry.Evict(m_memoryBudget, &Texture::Unload);
+		if (evicted > 0)
+			gameLog.Print("Evicted %u texture(s), %.2f MB resident\n", evicted, m_registry.GetStatistics().gpuBytes / (1024.0 * 1024.0));
+	}
+
+	void Texture::Clear()
+	{
+		m_registry.Clear(&Texture::Unload);
+
+		GpuMemory::Unregister(GpuResources::Texture, m_fallback);
+		glDeleteTextures(1, &m_fallback);
+		m_fallback = 0;
+	}
+
+	void Texture::SetMemoryBudget(std::size_t bytes)
+	{
+		m_memoryBudget = bytes;
+	}
+
+	bool Texture::IsLoaded(TextureHandle texture) const
+	{
+		TextureAsset* asset = m_registry.Get(texture);
+		return asset && asset->residentMip < asset->mipCount;
+	}
+
+	bool Texture::IsCompressionSupported() const
+	{
+		return m_s3tc;
+	}
+
+	unsigned int Texture::GetPendingLoads() const
+	{
+		return m_pendingLoads;
+	}
+
+	std::size_t Texture::GetMemoryBudget() const
+	{
+		return m_memoryBudget;
+	}
+
+	unsigned int Texture::GetTexture(TextureHandle texture)
+	{
+		TextureAsset* asset = m_registry.Get(texture);
+		if (!asset || asset->residentMip == asset->mipCount || asset->layer >= 0)
+			return m_fallback;
+
+		m_registry.Touch(texture);
+		return asset->texture;
+	}
+
+	int Texture::GetLayer(TextureHandle texture) const
+	{
+		//Layers share their base level with the rest of the array, so they only count once complete
+		TextureAsset* asset = m_registry.Get(texture);
+		if (!asset || asset->residentMip != 0)
+			return -1;
+
+		return asset->layer;
+	}
+
+	const Texture::Registry & Texture::GetRegistry() const
+	{
+		return m_registry;
+	}
+
+	GLenum Texture::GetInternalFormat(TextureFormats::ID format)
+	{
+		switch (format)
+		{
+		case TextureFormats::BC1: return COMPRESSED_RGB_S3TC_DXT1;
+		case TextureFormats::BC3: return COMPRESSED_RGBA_S3TC_DXT5;
+		case TextureFormats::BC5: return GL_COMPRESSED_RG_RGTC2;
+		default: return GL_RGBA8;
+		}
+	}
+
+	void Texture::RunLoad(LoadResult & result)
+	{
+		Clock::time_point start = Clock::now();
+		result.file = std::make_unique<MappedFile>();
+
+		//Stream straight from the mapped cache when it was cooked from the current source, otherwise cook and write it
+		if (TextureCache::Read(result.path, result.usage, result.compress, *result.file, result.view))
+		{
+			result.cacheHit = true;
+
+			//Fault the pages in here so the upload on the main thread never waits for the disk
+			const unsigned char* data = result.file->GetData();
+			volatile unsigned char touched = 0;
+			for (std::size_t i = 0; i < result.file->GetSize(); i += 4096)
+				touched ^= data[i];
+		}
+		else
+		{
+			result.file.reset();
+
+			if (TextureCache::Cook(result.path, result.usage, result.compress, result.cooked, result.error))
+			{
+				if (!TextureCache::Write(result.path, result.cooked))
+					std::cout << "WARNING::TEXTURECACHE:: Could not write " << TextureCache::GetCachePath(result.path) << std::endl;
+
+				result.view = TextureCache::CreateView(result.cooked);
+			}
+		}
+
+		result.parseTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	void Texture::Unload(TextureAsset & asset)
+	{
+		if (asset.layer >= 0)
+			asset.array->FreeLayer(asset.layer);
+		else
+		{
+			GpuMemory::Unregister(GpuResources::Texture, asset.texture);
+			glDeleteTextures(1, &asset.texture);
+		}
+	}
+
+	bool Texture::SupportsS3TC()
+	{
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+		for (GLint i = 0; i < count; i++)
+		{
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (extension && std::strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	bool Texture::BeginUpload()
+	{
+		LoadResult & result = *m_upload.result;
+		const TextureView & view = result.view;
+
+		if (!result.error.empty() || !m_registry.IsValid(result.texture))
+		{
+			if (!result.error.empty())
+				gameLog.Print("Failed to load %s: %s\n", result.path.c_str(), result.error.c_str());
+
+			m_registry.SetFailed(result.texture);
+			m_upload.result.reset();
+			m_pendingLoads--;
+			return false;
+		}
+
+		auto asset = std::make_unique<TextureAsset>();
+		asset->texture = 0;
+		asset->layer = -1;
+		asset->format = view.format;
+		asset->width = view.width;
+		asset->height = view.height;
+		asset->mipCount = view.mipCount;
+		asset->residentMip = view.mipCount;
+
+		if (result.array)
+		{
+			if (result.array->Matches(view))
+				asset->layer = result.array->AllocateLayer();
+
+			if (asset->layer >= 0)
+			{
+				asset->texture = result.array->GetTexture();
+				asset->array = result.array;
+			}
+			else
+				gameLog.Print("%s doesn't fit its texture array, loading it on its own\n", result.path.c_str());
+		}
+
+		std::size_t gpuBytes = 0;
+		for (unsigned int level = 0; level < view.mipCount; level++)
+			gpuBytes += view.mipSizes[level];
+
+		//The whole chain is allocated up front, only the base level moves as the finer mips arrive
+		if (asset->layer < 0)
+		{
+			glGenTextures(1, &asset->texture);
+			glBindTexture(GL_TEXTURE_2D, asset->texture);
+			glTexStorage2D(GL_TEXTURE_2D, view.mipCount, GetInternalFormat(view.format), view.width, view.height);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, view.mipCount - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, view.mipCount - 1);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			GpuMemory::Register(GpuResources::Texture, asset->texture, gpuBytes, result.path);
+		}
+
+		m_registry.SetLoaded(result.texture, std::move(asset), sizeof(TextureAsset), gpuBytes);
+		m_upload.nextLevel = view.mipCount;
+		m_upload.uploadTime = 0.0;
+
+		return true;
+	}
+
+	void Texture::UploadLevels(std::size_t & budget)
+	{
+		LoadResult & result = *m_upload.result;
+		const TextureView & view = result.view;
+
+		//Evicted or cleared while streaming, there is nothing left to upload into
+		TextureAsset* asset = m_registry.Get(result.texture);
+		if (!asset)
+		{
+			m_upload.result.reset();
+			m_pendingLoads--;
+			return;
+		}
+
+		Clock::time_point start = Clock::now();
+		if (asset->layer < 0)
+			glBindTexture(GL_TEXTURE_2D, asset->texture);
+
+		//At least one level goes up per call, coarsest first
+		while (m_upload.nextLevel > 0 && budget > 0)
+		{
+			unsigned int level = --m_upload.nextLevel;
+
+			if (asset->layer >= 0)
+				asset->array->UploadLevel(asset->layer, level, view);
+			else
+			{
+				unsigned int width = GetMipSize(view.width, level), height = GetMipSize(view.height, level);
+				if (view.format == TextureFormats::RGBA8)
+					glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, view.mips[level]);
+				else
+					glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GetInternalFormat(view.format), (GLsizei)view.mipSizes[level], view.mips[level]);
+
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+			}
+
+			asset->residentMip = level;
+			budget -= std::min(budget, view.mipSizes[level]);
+		}
+
+		if (asset->layer < 0)
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+		m_upload.uploadTime += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		if (m_upload.nextLevel == 0)
+			FinishUpload();
+	}
+
+	void Texture::FinishUpload()
+	{
+		LoadResult & result = *m_upload.result;
+		const TextureView & view = result.view;
+		double totalTime = std::chrono::duration<double, std::milli>(Clock::now() - result.requested).count();
+
+		gameLog.Print("Loaded %s in %.2f ms (%s, %ux%u %s, %u mips, parse %.2f ms, upload %.2f ms)\n", result.path.c_str(), totalTime,
+					  result.cacheHit ? "cache hit" : "cooked", view.width, view.height, TextureCache::GetFormatName(view.format), view.mipCount,
+					  result.parseTime, m_upload.uploadTime);
+
+		//Releasing the result also unmaps the cache file
+		m_upload.result.reset();
+		m_pendingLoads--;
+	}
+}
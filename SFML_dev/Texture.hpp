@@ -0,0 +1,162 @@
+#pragma once
+#include <glad/glad.h>
+#include "TextureCache.hpp"
+#include "AssetRegistry.hpp"
+#include "ResourceIdentifiers.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace px
+{
+	//Bytes of mip data uploaded per frame
+	const std::size_t TEXTURE_UPLOAD_BUDGET = 2 << 20;
+
+	//GPU bytes of unreferenced textures kept resident before the least recently used ones are evicted
+	const std::size_t TEXTURE_MEMORY_BUDGET = 256 << 20;
+
+	//Square textures of one format and size sharing a single GL_TEXTURE_2D_ARRAY, so materials using them
+	//can be drawn without rebinding. Every layer has the full mip chain
+	class TextureArray
+	{
+	public:
+		TextureArray(TextureFormats::ID format, unsigned int size, unsigned int layerCapacity);
+		~TextureArray();
+
+		TextureArray(const TextureArray &) = delete;
+		TextureArray & operator=(const TextureArray &) = delete;
+
+	public:
+		bool Matches(const TextureView & texture) const;
+		int AllocateLayer();
+		void FreeLayer(int layer);
+		void UploadLevel(int layer, unsigned int level, const TextureView & texture);
+
+	public:
+		unsigned int GetTexture() const;
+		TextureFormats::ID GetFormat() const;
+		unsigned int GetSize() const;
+		unsigned int GetLayerCapacity() const;
+		unsigned int GetUsedLayers() const;
+
+	private:
+		unsigned int m_texture;
+		TextureFormats::ID m_format;
+		unsigned int m_size;
+		unsigned int m_mipCount;
+		unsigned int m_layerCapacity;
+		std::vector<int> m_freeLayers;
+	};
+
+	//One loaded image, either a texture of its own or a layer inside a TextureArray
+	struct TextureAsset
+	{
+		unsigned int texture;
+		int layer;
+		std::shared_ptr<TextureArray> array;
+		TextureFormats::ID format;
+		unsigned int width;
+		unsigned int height;
+		unsigned int mipCount;
+
+		//Finest level uploaded so far, mipCount while nothing is on the GPU yet
+		unsigned int residentMip;
+	};
+
+	//Textures are addressed by path like models. Images are cooked on the pool and streamed in
+	//from the smallest mip up, so a texture shows blurry right away and sharpens over the next frames
+	class Texture
+	{
+	public:
+		typedef AssetRegistry<TextureAsset> Registry;
+
+	public:
+		explicit Texture(std::shared_ptr<ThreadPool> threadPool);
+
+	public:
+		TextureHandle Acquire(const std::string & path, TextureUsages::ID usage = TextureUsages::Color);
+
+		//Loads into a free layer of the array when format and size match, otherwise into a texture of its own
+		TextureHandle AcquireLayer(const std::string & path, std::shared_ptr<TextureArray> array, TextureUsages::ID usage = TextureUsages::Color);
+		void AddReference(TextureHandle texture);
+		void Release(TextureHandle texture);
+		void ProcessUploads();
+		void Clear();
+
+	public:
+		void SetMemoryBudget(std::size_t bytes);
+
+	public:
+		bool IsLoaded(TextureHandle texture) const;
+		bool IsCompressionSupported() const;
+		unsigned int GetPendingLoads() const;
+		std::size_t GetMemoryBudget() const;
+
+		//Falls back to a 1x1 white texture until at least one mip is resident
+		unsigned int GetTexture(TextureHandle texture);
+		int GetLayer(TextureHandle texture) const;
+		const Registry & GetRegistry() const;
+
+	public:
+		static GLenum GetInternalFormat(TextureFormats::ID format);
+
+	private:
+		typedef std::chrono::high_resolution_clock Clock;
+
+		//Filled on a worker, the view points either into the mapped cache or into the cooked data
+		struct LoadResult
+		{
+			TextureHandle texture;
+			std::string path;
+			TextureUsages::ID usage;
+			bool compress;
+			std::shared_ptr<TextureArray> array;
+			std::unique_ptr<MappedFile> file;
+			TextureData cooked;
+			TextureView view;
+			std::string error;
+			bool cacheHit;
+			Clock::time_point requested;
+			double parseTime;
+		};
+
+		//Shared with the workers so a load finishing after the texture holder is gone stays safe
+		struct LoadQueue
+		{
+			std::mutex mutex;
+			std::deque<std::unique_ptr<LoadResult>> finished;
+		};
+
+		//Texture currently streaming in, levels go up from the coarsest one
+		struct Upload
+		{
+			std::unique_ptr<LoadResult> result;
+			unsigned int nextLevel;
+			double uploadTime;
+		};
+
+	private:
+		static void RunLoad(LoadResult & result);
+		static void Unload(TextureAsset & asset);
+		static bool SupportsS3TC();
+
+	private:
+		TextureHandle StartLoad(const std::string & path, TextureUsages::ID usage, std::shared_ptr<TextureArray> array);
+		bool BeginUpload();
+		void UploadLevels(std::size_t & budget);
+		void FinishUpload();
+
+	private:
+		Registry m_registry;
+		std::shared_ptr<ThreadPool> m_threadPool;
+		std::shared_ptr<LoadQueue> m_queue;
+		Upload m_upload;
+		unsigned int m_fallback;
+		std::size_t m_memoryBudget;
+		unsigned int m_pendingLoads;
+		bool m_s3tc;
+	};
+}
@@ -0,0 +1,343 @@
+#include "TextureCache.hpp"
+#include "TextureCompressor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace px
+{
+	namespace
+	{
+		const char TEXTURE_CACHE_MAGIC[4] = { 'P', 'X', 'T', 'X' };
+		const std::uint64_t BLOB_ALIGNMENT = 16;
+
+		//On-disk layout, written and mapped as is
+		struct FileHeader
+		{
+			char magic[4];
+			std::uint32_t version;
+			std::uint64_t sourceSize;
+			std::int64_t sourceTime;
+			std::uint32_t width;
+			std::uint32_t height;
+			std::uint32_t format;
+			std::uint32_t usage;
+			std::uint32_t mipCount;
+			std::uint32_t reserved;
+		};
+
+		struct FileMip
+		{
+			std::uint64_t offset;
+			std::uint64_t size;
+		};
+
+		static_assert(sizeof(FileHeader) == 48, "Texture cache header layout changed");
+		static_assert(sizeof(FileMip) == 16, "Texture cache mip layout changed");
+
+		std::uint64_t Align(std::uint64_t offset)
+		{
+			return (offset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+		}
+
+		float ToLinear(std::uint8_t value)
+		{
+			float c = value / 255.f;
+			return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		//sRGB to linear for every byte value
+		struct LinearTable
+		{
+			LinearTable()
+			{
+				for (unsigned int i = 0; i < 256; i++)
+					values[i] = ToLinear((std::uint8_t)i);
+			}
+
+			float values[256];
+		};
+
+		std::uint8_t ToSrgb(float value)
+		{
+			float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+			return (std::uint8_t)std::round(std::min(std::max(c, 0.f), 1.f) * 255.f);
+		}
+	}
+
+	std::string TextureCache::GetCachePath(const std::string & sourcePath)
+	{
+		std::size_t dot = sourcePath.find_last_of('.');
+		std::size_t slash = sourcePath.find_last_of("/\\");
+
+		if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+			return sourcePath + ".pxtex";
+
+		return sourcePath.substr(0, dot) + ".pxtex";
+	}
+
+	TextureView TextureCache::CreateView(const TextureData & texture)
+	{
+		TextureView view;
+		view.format = texture.format;
+		view.width = texture.width;
+		view.height = texture.height;
+		view.mipCount = (unsigned int)std::min<std::size_t>(texture.mips.size(), MAX_TEXTURE_MIPS);
+
+		for (unsigned int level = 0; level < view.mipCount; level++)
+		{
+			view.mips[level] = texture.mips[level].data();
+			view.mipSizes[level] = texture.mips[level].size();
+		}
+
+		return view;
+	}
+
+	unsigned int TextureCache::GetMipCount(unsigned int width, unsigned int height)
+	{
+		unsigned int count = 1;
+		for (unsigned int size = std::max(width, height); size > 1; size /= 2)
+			count++;
+
+		return std::min(count, MAX_TEXTURE_MIPS);
+	}
+
+	const char* TextureCache::GetFormatName(TextureFormats::ID format)
+	{
+		switch (format)
+		{
+		case TextureFormats::BC1: return "BC1";
+		case TextureFormats::BC3: return "BC3";
+		case TextureFormats::BC5: return "BC5";
+		default: return "RGBA8";
+		}
+	}
+
+	bool TextureCache::Cook(const std::string & sourcePath, TextureUsages::ID usage, bool compress, TextureData & texture, std::string & error)
+	{
+		int width = 0, height = 0, channels = 0;
+		stbi_uc* pixels = stbi_load(sourcePath.c_str(), &width, &height, &channels, 4);
+		if (!pixels)
+		{
+			error = std::string("ERROR::STB_IMAGE:: ") + stbi_failure_reason();
+			return false;
+		}
+
+		texture.usage = usage;
+		texture.width = (unsigned int)width;
+		texture.height = (unsigned int)height;
+
+		//Normals keep two channels, color only pays for alpha when some pixel actually uses it
+		if (!compress)
+			texture.format = TextureFormats::RGBA8;
+		else if (usage == TextureUsages::Normal)
+			texture.format = TextureFormats::BC5;
+		else
+		{
+			texture.format = TextureFormats::BC1;
+			for (std::size_t i = 3; i < (std::size_t)width * height * 4; i += 4)
+			{
+				if (pixels[i] < 255)
+				{
+					texture.format = TextureFormats::BC3;
+					break;
+				}
+			}
+		}
+
+		unsigned int mipCount = GetMipCount(texture.width, texture.height);
+		texture.mips.resize(mipCount);
+
+		std::vector<std::uint8_t> level(pixels, pixels + (std::size_t)width * height * 4);
+		stbi_image_free(pixels);
+
+		//Every level is filtered from the uncompressed one above it
+		unsigned int levelWidth = texture.width, levelHeight = texture.height;
+		for (unsigned int i = 0; i < mipCount; i++)
+		{
+			Compress(level, levelWidth, levelHeight, texture.format, texture.mips[i]);
+
+			if (i + 1 < mipCount)
+			{
+				std::vector<std::uint8_t> next;
+				Downsample(level, levelWidth, levelHeight, usage, next);
+				level.swap(next);
+				levelWidth = std::max(levelWidth / 2, 1u);
+				levelHeight = std::max(levelHeight / 2, 1u);
+			}
+		}
+
+		return true;
+	}
+
+	bool TextureCache::Write(const std::string & sourcePath, const TextureData & texture)
+	{
+		FileHeader header;
+		std::memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(header.magic));
+		header.version = TEXTURE_CACHE_VERSION;
+		header.width = texture.width;
+		header.height = texture.height;
+		header.format = texture.format;
+		header.usage = texture.usage;
+		header.mipCount = (std::uint32_t)texture.mips.size();
+		header.reserved = 0;
+
+		if (!MappedFile::GetStamp(sourcePath, header.sourceSize, header.sourceTime))
+			return false;
+
+		//Lay out the mips after the mip table
+		std::vector<FileMip> mips(texture.mips.size());
+		std::uint64_t offset = sizeof(FileHeader) + mips.size() * sizeof(FileMip);
+
+		for (std::size_t i = 0; i < mips.size(); i++)
+		{
+			mips[i].offset = offset = Align(offset);
+			mips[i].size = texture.mips[i].size();
+			offset += mips[i].size;
+		}
+
+		std::ofstream file(GetCachePath(sourcePath), std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		file.write((const char*)&header, sizeof(FileHeader));
+		file.write((const char*)mips.data(), mips.size() * sizeof(FileMip));
+
+		static const char zeros[BLOB_ALIGNMENT] = {};
+		for (std::size_t i = 0; i < mips.size(); i++)
+		{
+			file.write(zeros, mips[i].offset - (std::uint64_t)file.tellp());
+			file.write((const char*)texture.mips[i].data(), texture.mips[i].size());
+		}
+
+		return file.good();
+	}
+
+	bool TextureCache::Read(const std::string & sourcePath, TextureUsages::ID usage, bool compress, MappedFile & file, TextureView & texture)
+	{
+		std::uint64_t sourceSize;
+		std::int64_t sourceTime;
+		if (!MappedFile::GetStamp(sourcePath, sourceSize, sourceTime))
+			return false;
+
+		if (!file.Open(GetCachePath(sourcePath)))
+			return false;
+
+		//Anything that doesn't match exactly is treated as a miss and gets re-cooked
+		const unsigned char* data = file.GetData();
+		std::size_t size = file.GetSize();
+
+		if (size < sizeof(FileHeader))
+			return false;
+
+		const FileHeader* header = (const FileHeader*)data;
+		if (std::memcmp(header->magic, TEXTURE_CACHE_MAGIC, sizeof(header->magic)) != 0 || header->version != TEXTURE_CACHE_VERSION ||
+			header->sourceSize != sourceSize || header->sourceTime != sourceTime)
+			return false;
+
+		if (header->usage != (std::uint32_t)usage || (header->format != TextureFormats::RGBA8) != compress)
+			return false;
+
+		if (header->mipCount == 0 || header->mipCount > MAX_TEXTURE_MIPS || sizeof(FileHeader) + header->mipCount * sizeof(FileMip) > size)
+			return false;
+
+		const FileMip* mips = (const FileMip*)(data + sizeof(FileHeader));
+		texture.format = (TextureFormats::ID)header->format;
+		texture.width = header->width;
+		texture.height = header->height;
+		texture.mipCount = header->mipCount;
+
+		for (std::uint32_t i = 0; i < header->mipCount; i++)
+		{
+			if (mips[i].offset + mips[i].size > size)
+				return false;
+
+			texture.mips[i] = data + mips[i].offset;
+			texture.mipSizes[i] = (std::size_t)mips[i].size;
+		}
+
+		return true;
+	}
+
+	void TextureCache::Downsample(const std::vector<std::uint8_t> & source, unsigned int width, unsigned int height, TextureUsages::ID usage, std::vector<std::uint8_t> & destination)
+	{
+		unsigned int targetWidth = std::max(width / 2, 1u), targetHeight = std::max(height / 2, 1u);
+		destination.resize((std::size_t)targetWidth * targetHeight * 4);
+
+		//Averaging has to happen in linear space, the table is built once even with several cooks running
+		static const LinearTable linear;
+
+		for (unsigned int y = 0; y < targetHeight; y++)
+		{
+			for (unsigned int x = 0; x < targetWidth; x++)
+			{
+				//2x2 box, odd edges reuse the last row or column
+				const std::uint8_t* texels[4];
+				unsigned int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+				unsigned int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+				texels[0] = &source[((std::size_t)y0 * width + x0) * 4];
+				texels[1] = &source[((std::size_t)y0 * width + x1) * 4];
+				texels[2] = &source[((std::size_t)y1 * width + x0) * 4];
+				texels[3] = &source[((std::size_t)y1 * width + x1) * 4];
+
+				std::uint8_t* output = &destination[((std::size_t)y * targetWidth + x) * 4];
+				float sum[4] = { 0.f, 0.f, 0.f, 0.f };
+
+				if (usage == TextureUsages::Normal)
+				{
+					//Average the vectors and put them back on the unit sphere
+					for (unsigned int t = 0; t < 4; t++)
+					{
+						for (unsigned int c = 0; c < 3; c++)
+							sum[c] += texels[t][c] / 127.5f - 1.f;
+						sum[3] += texels[t][3];
+					}
+
+					float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+					for (unsigned int c = 0; c < 3; c++)
+					{
+						float n = length > 0.f ? sum[c] / length : (c == 2 ? 1.f : 0.f);
+						output[c] = (std::uint8_t)std::round((n + 1.f) * 127.5f);
+					}
+				}
+				else
+				{
+					for (unsigned int t = 0; t < 4; t++)
+					{
+						for (unsigned int c = 0; c < 3; c++)
+							sum[c] += linear.values[texels[t][c]];
+						sum[3] += texels[t][3];
+					}
+
+					for (unsigned int c = 0; c < 3; c++)
+						output[c] = ToSrgb(sum[c] * 0.25f);
+				}
+
+				output[3] = (std::uint8_t)std::round(sum[3] * 0.25f);
+			}
+		}
+	}
+
+	void TextureCache::Compress(const std::vector<std::uint8_t> & rgba, unsigned int width, unsigned int height, TextureFormats::ID format, std::vector<std::uint8_t> & blocks)
+	{
+		switch (format)
+		{
+		case TextureFormats::BC1:
+			TextureCompressor::CompressBC1(rgba.data(), width, height, blocks);
+			break;
+		case TextureFormats::BC3:
+			TextureCompressor::CompressBC3(rgba.data(), width, height, blocks);
+			break;
+		case TextureFormats::BC5:
+			TextureCompressor::CompressBC5(rgba.data(), width, height, blocks);
+			break;
+		default:
+			blocks = rgba;
+			break;
+		}
+	}
+}
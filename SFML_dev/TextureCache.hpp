@@ -0,0 +1,79 @@
+#pragma once
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace px
+{
+	//Bump whenever the cooked layout or the cooking steps change, stale caches are then re-cooked
+	const std::uint32_t TEXTURE_CACHE_VERSION = 1;
+
+	//Enough levels for a 32k texture
+	const unsigned int MAX_TEXTURE_MIPS = 16;
+
+	namespace TextureFormats
+	{
+		enum ID
+		{
+			RGBA8,
+			BC1,
+			BC3,
+			BC5
+		};
+	}
+
+	//Decides how mips are filtered and which block format a texture is compressed to
+	namespace TextureUsages
+	{
+		enum ID
+		{
+			Color,
+			Normal
+		};
+	}
+
+	//CPU side result of cooking one image, mip 0 first
+	struct TextureData
+	{
+		TextureFormats::ID format;
+		TextureUsages::ID usage;
+		unsigned int width;
+		unsigned int height;
+		std::vector<std::vector<std::uint8_t>> mips;
+	};
+
+	//One texture inside a mapped cache, the pointers are valid as long as the file stays mapped
+	struct TextureView
+	{
+		TextureFormats::ID format;
+		unsigned int width;
+		unsigned int height;
+		unsigned int mipCount;
+		const std::uint8_t* mips[MAX_TEXTURE_MIPS];
+		std::size_t mipSizes[MAX_TEXTURE_MIPS];
+	};
+
+	//Binary .pxtex files cooked next to the source image
+	class TextureCache
+	{
+	public:
+		static std::string GetCachePath(const std::string & sourcePath);
+		static TextureView CreateView(const TextureData & texture);
+		static unsigned int GetMipCount(unsigned int width, unsigned int height);
+		static const char* GetFormatName(TextureFormats::ID format);
+
+	public:
+		//Decodes the source, builds the full mip chain and compresses it unless compress is false
+		static bool Cook(const std::string & sourcePath, TextureUsages::ID usage, bool compress, TextureData & texture, std::string & error);
+		static bool Write(const std::string & sourcePath, const TextureData & texture);
+
+		//Only succeeds when the cache matches the source, the usage and the compression setting
+		static bool Read(const std::string & sourcePath, TextureUsages::ID usage, bool compress, MappedFile & file, TextureView & texture);
+
+	private:
+		static void Downsample(const std::vector<std::uint8_t> & source, unsigned int width, unsigned int height, TextureUsages::ID usage, std::vector<std::uint8_t> & destination);
+		static void Compress(const std::vector<std::uint8_t> & rgba, unsigned int width, unsigned int height, TextureFormats::ID format, std::vector<std::uint8_t> & blocks);
+	};
+}
@@ -0,0 +1,257 @@
+#include "TextureCompressor.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace px
+{
+	namespace
+	{
+		const unsigned int BLOCK_PIXELS = 16;
+
+		std::uint16_t To565(const float color[3])
+		{
+			unsigned int r = (unsigned int)std::round(std::min(std::max(color[0], 0.f), 255.f) * 31.f / 255.f);
+			unsigned int g = (unsigned int)std::round(std::min(std::max(color[1], 0.f), 255.f) * 63.f / 255.f);
+			unsigned int b = (unsigned int)std::round(std::min(std::max(color[2], 0.f), 255.f) * 31.f / 255.f);
+			return (std::uint16_t)((r << 11) | (g << 5) | b);
+		}
+
+		void From565(std::uint16_t color, int output[3])
+		{
+			//Replicate the high bits into the low ones, the same expansion the hardware does
+			int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+			output[0] = (r << 3) | (r >> 2);
+			output[1] = (g << 2) | (g >> 4);
+			output[2] = (b << 3) | (b >> 2);
+		}
+
+		void WriteU16(std::uint8_t* output, std::uint16_t value)
+		{
+			output[0] = (std::uint8_t)(value & 0xff);
+			output[1] = (std::uint8_t)(value >> 8);
+		}
+	}
+
+	void TextureCompressor::CompressBC1(const std::uint8_t* rgba, unsigned int width, unsigned int height, std::vector<std::uint8_t> & blocks)
+	{
+		blocks.resize(GetCompressedSize(width, height, 8));
+		std::uint8_t* output = blocks.data();
+		std::uint8_t block[64];
+
+		for (unsigned int y = 0; y < height; y += 4)
+		{
+			for (unsigned int x = 0; x < width; x += 4, output += 8)
+			{
+				FetchBlock(rgba, width, height, x, y, block);
+				EncodeColorBlock(block, output);
+			}
+		}
+	}
+
+	void TextureCompressor::CompressBC3(const std::uint8_t* rgba, unsigned int width, unsigned int height, std::vector<std::uint8_t> & blocks)
+	{
+		blocks.resize(GetCompressedSize(width, height, 16));
+		std::uint8_t* output = blocks.data();
+		std::uint8_t block[64];
+
+		for (unsigned int y = 0; y < height; y += 4)
+		{
+			for (unsigned int x = 0; x < width; x += 4, output += 16)
+			{
+				FetchBlock(rgba, width, height, x, y, block);
+				EncodeChannelBlock(block, 3, output);
+				EncodeColorBlock(block, output + 8);
+			}
+		}
+	}
+
+	void TextureCompressor::CompressBC5(const std::uint8_t* rgba, unsigned int width, unsigned int height, std::vector<std::uint8_t> & blocks)
+	{
+		blocks.resize(GetCompressedSize(width, height, 16));
+		std::uint8_t* output = blocks.data();
+		std::uint8_t block[64];
+
+		for (unsigned int y = 0; y < height; y += 4)
+		{
+			for (unsigned int x = 0; x < width; x += 4, output += 16)
+			{
+				FetchBlock(rgba, width, height, x, y, block);
+				EncodeChannelBlock(block, 0, output);
+				EncodeChannelBlock(block, 1, output + 8);
+			}
+		}
+	}
+
+	std::size_t TextureCompressor::GetCompressedSize(unsigned int width, unsigned int height, unsigned int blockBytes)
+	{
+		//Mips below 4x4 still take up a whole block
+		return (std::size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+	}
+
+	void TextureCompressor::FetchBlock(const std::uint8_t* rgba, unsigned int width, unsigned int height, unsigned int x, unsigned int y, std::uint8_t block[64])
+	{
+		//Blocks hanging over the edge repeat the last row and column
+		for (unsigned int row = 0; row < 4; row++)
+		{
+			unsigned int sourceY = std::min(y + row, height - 1);
+			for (unsigned int column = 0; column < 4; column++)
+			{
+				unsigned int sourceX = std::min(x + column, width - 1);
+				const std::uint8_t* pixel = rgba + ((std::size_t)sourceY * width + sourceX) * 4;
+				std::copy(pixel, pixel + 4, block + (row * 4 + column) * 4);
+			}
+		}
+	}
+
+	void TextureCompressor::EncodeColorBlock(const std::uint8_t block[64], std::uint8_t* output)
+	{
+		//Fit a line through the colors along their principal axis
+		float mean[3] = { 0.f, 0.f, 0.f };
+		for (unsigned int i = 0; i < BLOCK_PIXELS; i++)
+		{
+			for (unsigned int c = 0; c < 3; c++)
+				mean[c] += block[i * 4 + c];
+		}
+
+		for (unsigned int c = 0; c < 3; c++)
+			mean[c] /= BLOCK_PIXELS;
+
+		float covariance[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+		for (unsigned int i = 0; i < BLOCK_PIXELS; i++)
+		{
+			float r = block[i * 4] - mean[0], g = block[i * 4 + 1] - mean[1], b = block[i * 4 + 2] - mean[2];
+			covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+			covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+		}
+
+		//A few rounds of power iteration are plenty for 16 points
+		float axis[3] = { 1.f, 1.f, 1.f };
+		for (unsigned int iteration = 0; iteration < 4; iteration++)
+		{
+			float next[3] =
+			{
+				covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+				covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+				covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+			};
+
+			float length = std::max(std::abs(next[0]), std::max(std::abs(next[1]), std::abs(next[2])));
+			if (length <= 0.f)
+				break;
+
+			for (unsigned int c = 0; c < 3; c++)
+				axis[c] = next[c] / length;
+		}
+
+		float lengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		float minProjection = 0.f, maxProjection = 0.f;
+
+		for (unsigned int i = 0; i < BLOCK_PIXELS; i++)
+		{
+			float projection = ((block[i * 4] - mean[0]) * axis[0] + (block[i * 4 + 1] - mean[1]) * axis[1] + (block[i * 4 + 2] - mean[2]) * axis[2]) / lengthSquared;
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		//Pull the endpoints in a little, the extremes are usually single outliers
+		float inset = (maxProjection - minProjection) / 16.f;
+		minProjection += inset;
+		maxProjection -= inset;
+
+		float high[3], low[3];
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			high[c] = mean[c] + axis[c] * maxProjection;
+			low[c] = mean[c] + axis[c] * minProjection;
+		}
+
+		std::uint16_t color0 = To565(high), color1 = To565(low);
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		WriteU16(output, color0);
+		WriteU16(output + 2, color1);
+
+		//Equal endpoints would switch the block into three color mode, index 0 is correct for all of it
+		std::uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][3];
+			From565(color0, palette[0]);
+			From565(color1, palette[1]);
+
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (unsigned int i = 0; i < BLOCK_PIXELS; i++)
+			{
+				unsigned int best = 0;
+				int bestDistance = 0x7fffffff;
+
+				for (unsigned int p = 0; p < 4; p++)
+				{
+					int r = block[i * 4] - palette[p][0], g = block[i * 4 + 1] - palette[p][1], b = block[i * 4 + 2] - palette[p][2];
+					int distance = r * r + g * g + b * b;
+					if (distance < bestDistance)
+					{
+						best = p;
+						bestDistance = distance;
+					}
+				}
+
+				indices |= best << (i * 2);
+			}
+		}
+
+		WriteU16(output + 4, (std::uint16_t)(indices & 0xffff));
+		WriteU16(output + 6, (std::uint16_t)(indices >> 16));
+	}
+
+	void TextureCompressor::EncodeChannelBlock(const std::uint8_t block[64], unsigned int channel, std::uint8_t* output)
+	{
+		//BC4 layout, shared by the BC3 alpha and both BC5 channels
+		int high = 0, low = 255;
+		for (unsigned int i = 0; i < BLOCK_PIXELS; i++)
+		{
+			high = std::max(high, (int)block[i * 4 + channel]);
+			low = std::min(low, (int)block[i * 4 + channel]);
+		}
+
+		output[0] = (std::uint8_t)high;
+		output[1] = (std::uint8_t)low;
+
+		//high > low selects the eight value mode, with equal endpoints index 0 already matches every pixel
+		std::uint64_t indices = 0;
+		if (high > low)
+		{
+			int palette[8] = { high, low };
+			for (int k = 2; k < 8; k++)
+				palette[k] = ((8 - k) * high + (k - 1) * low) / 7;
+
+			for (unsigned int i = 0; i < BLOCK_PIXELS; i++)
+			{
+				int value = block[i * 4 + channel];
+				unsigned int best = 0;
+				int bestDistance = 256;
+
+				for (unsigned int p = 0; p < 8; p++)
+				{
+					int distance = std::abs(value - palette[p]);
+					if (distance < bestDistance)
+					{
+						best = p;
+						bestDistance = distance;
+					}
+				}
+
+				indices |= (std::uint64_t)best << (i * 3);
+			}
+		}
+
+		for (unsigned int i = 0; i < 6; i++)
+			output[2 + i] = (std::uint8_t)(indices >> (i * 8));
+	}
+}
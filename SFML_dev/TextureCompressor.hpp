@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace px
+{
+	//Block compression of RGBA8 images on the CPU, used when cooking textures.
+	//Encodes 4x4 blocks with bounding box endpoints, tuned for speed over quality
+	class TextureCompressor
+	{
+	public:
+		//Color only, 8 bytes per block
+		static void CompressBC1(const std::uint8_t* rgba, unsigned int width, unsigned int height, std::vector<std::uint8_t> & blocks);
+
+		//Color plus interpolated alpha, 16 bytes per block
+		static void CompressBC3(const std::uint8_t* rgba, unsigned int width, unsigned int height, std::vector<std::uint8_t> & blocks);
+
+		//Red and green as two independent channels, meant for tangent space normals. 16 bytes per block
+		static void CompressBC5(const std::uint8_t* rgba, unsigned int width, unsigned int height, std::vector<std::uint8_t> & blocks);
+
+	public:
+		static std::size_t GetCompressedSize(unsigned int width, unsigned int height, unsigned int blockBytes);
+
+	private:
+		static void FetchBlock(const std::uint8_t* rgba, unsigned int width, unsigned int height, unsigned int x, unsigned int y, std::uint8_t block[64]);
+		static void EncodeColorBlock(const std::uint8_t block[64], std::uint8_t* output);
+		static void EncodeChannelBlock(const std::uint8_t block[64], unsigned int channel, std::uint8_t* output);
+	};
+}
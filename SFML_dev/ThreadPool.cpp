@@ -0,0 +1,67 @@
+#include "ThreadPool.hpp"
+
+namespace px
+{
+	ThreadPool::ThreadPool(unsigned int threadCount) : m_stopping(false)
+	{
+		//Leave one core for the main thread by default
+		if (threadCount == 0)
+		{
+			unsigned int cores = std::thread::hardware_concurrency();
+			threadCount = cores > 1 ? cores - 1 : 1;
+		}
+
+		for (unsigned int i = 0; i < threadCount; i++)
+			m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+
+		m_condition.notify_all();
+
+		for (auto & worker : m_workers)
+			worker.join();
+	}
+
+	void ThreadPool::Enqueue(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.push_back(std::move(task));
+		}
+
+		m_condition.notify_one();
+	}
+
+	unsigned int ThreadPool::GetThreadCount() const
+	{
+		return (unsigned int)m_workers.size();
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+
+				//Drain what is queued before leaving so nobody waits on a dropped task
+				if (m_tasks.empty())
+					return;
+
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+			}
+
+			task();
+		}
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace px
+{
+	//Fixed set of worker threads pulling tasks from one shared queue
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(unsigned int threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool & operator=(const ThreadPool &) = delete;
+
+	public:
+		void Enqueue(std::function<void()> task);
+
+	public:
+		unsigned int GetThreadCount() const;
+
+	private:
+		void WorkerLoop();
+
+	private:
+		std::vector<std::thread> m_workers;
+		std::deque<std::function<void()>> m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stopping;
+	};
+}
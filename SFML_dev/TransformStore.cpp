@@ -0,0 +1,558 @@
+#include "TransformStore.hpp"
+#include "JobSystem.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define PX_TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace px
+{
+	namespace
+	{
+		//Transforms composed per job, a multiple of four so every job keeps the SSE lanes full
+		const std::size_t TRANSFORMS_PER_JOB = 4096;
+
+		inline std::size_t GetSlot(const TransformID* indices, std::size_t i)
+		{
+			return indices ? indices[i] : i;
+		}
+
+		void ComposeOne(float x, float y, float z, float w, glm::vec3 position, glm::vec3 scale, glm::mat4 & world, glm::mat3 & normal)
+		{
+			//Same closed form as the batched path, a unit quaternion's rotation matrix written out column by column
+			glm::vec3 c0(1.f - 2.f * (y * y + z * z), 2.f * (x * y + w * z), 2.f * (x * z - w * y));
+			glm::vec3 c1(2.f * (x * y - w * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z + w * x));
+			glm::vec3 c2(2.f * (x * z + w * y), 2.f * (y * z - w * x), 1.f - 2.f * (x * x + y * y));
+
+			world[0] = glm::vec4(c0 * scale.x, 0.f);
+			world[1] = glm::vec4(c1 * scale.y, 0.f);
+			world[2] = glm::vec4(c2 * scale.z, 0.f);
+			world[3] = glm::vec4(position, 1.f);
+
+			//The inverse transpose of R*S is R*S^-1
+			normal[0] = c0 / scale.x;
+			normal[1] = c1 / scale.y;
+			normal[2] = c2 / scale.z;
+		}
+
+#ifdef PX_TRANSFORM_SSE
+		inline __m128 Gather(const float* values, const TransformID* indices, std::size_t i)
+		{
+			if (!indices)
+				return _mm_loadu_ps(values + i);
+
+			return _mm_set_ps(values[indices[i + 3]], values[indices[i + 2]], values[indices[i + 1]], values[indices[i]]);
+		}
+
+		//Takes one matrix column as x, y, z and w of four transforms and writes it into each of their matrices
+		inline void ScatterColumn(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* worlds, const TransformID* indices, std::size_t i, unsigned int column)
+		{
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			_mm_storeu_ps(&worlds[GetSlot(indices, i + 0)][column][0], x);
+			_mm_storeu_ps(&worlds[GetSlot(indices, i + 1)][column][0], y);
+			_mm_storeu_ps(&worlds[GetSlot(indices, i + 2)][column][0], z);
+			_mm_storeu_ps(&worlds[GetSlot(indices, i + 3)][column][0], w);
+		}
+
+		//A mat3 column is three floats, the fourth lane is dropped so nothing past the matrix is touched
+		inline void StoreColumn3(float* destination, __m128 column)
+		{
+			_mm_storel_pi((__m64*)destination, column);
+			_mm_store_ss(destination + 2, _mm_movehl_ps(column, column));
+		}
+
+		inline void ScatterNormals(__m128 c0x, __m128 c0y, __m128 c0z, __m128 c1x, __m128 c1y, __m128 c1z, __m128 c2x, __m128 c2y, __m128 c2z,
+								   glm::mat3* normals, const TransformID* indices, std::size_t i)
+		{
+			__m128 c0w = _mm_setzero_ps(), c1w = _mm_setzero_ps(), c2w = _mm_setzero_ps();
+			_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+			_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+			_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+
+			//After the transposes each register holds one column of one transform
+			__m128 columns[4][3] =
+			{
+				{ c0x, c1x, c2x },
+				{ c0y, c1y, c2y },
+				{ c0z, c1z, c2z },
+				{ c0w, c1w, c2w }
+			};
+
+			for (unsigned int lane = 0; lane < 4; lane++)
+			{
+				float* normal = &normals[GetSlot(indices, i + lane)][0][0];
+				StoreColumn3(normal + 0, columns[lane][0]);
+				StoreColumn3(normal + 3, columns[lane][1]);
+				StoreColumn3(normal + 6, columns[lane][2]);
+			}
+		}
+#endif
+	}
+
+	TransformStore::TransformStore() : m_orderDirty(false)
+	{
+	}
+
+	TransformID TransformStore::Create(glm::vec3 position, glm::vec3 scale, glm::quat orientation)
+	{
+		TransformID id;
+		if (!m_free.empty())
+		{
+			id = m_free.back();
+			m_free.pop_back();
+		}
+		else
+		{
+			id = (TransformID)m_positionX.size();
+			m_positionX.push_back(0.f); m_positionY.push_back(0.f); m_positionZ.push_back(0.f);
+			m_rotationX.push_back(0.f); m_rotationY.push_back(0.f); m_rotationZ.push_back(0.f); m_rotationW.push_back(1.f);
+			m_scaleX.push_back(1.f); m_scaleY.push_back(1.f); m_scaleZ.push_back(1.f);
+			m_angles.push_back(glm::vec3(0.f));
+			m_locals.push_back(glm::mat4()); m_worlds.push_back(glm::mat4());
+			m_localNormals.push_back(glm::mat3()); m_normals.push_back(glm::mat3());
+			m_dirtyFlags.push_back(0);
+			m_parents.push_back(INVALID_TRANSFORM);
+			m_alive.push_back(0);
+			m_positions.push_back(INVALID_TRANSFORM);
+		}
+
+		m_angles[id] = glm::vec3(0.f);
+		m_parents[id] = INVALID_TRANSFORM;
+		m_alive[id] = 1;
+		m_orderDirty = true;
+		SetPosition(id, position);
+		SetOrientation(id, orientation);
+		SetScale(id, scale);
+
+		return id;
+	}
+
+	void TransformStore::Destroy(TransformID id)
+	{
+		//The slot may still be queued, it is skipped once it has left the order
+		m_alive[id] = 0;
+		m_parents[id] = INVALID_TRANSFORM;
+		m_orderDirty = true;
+		m_free.push_back(id);
+
+		//Children become roots, their locals are now their worlds. Unlinking them here also keeps them from
+		//ending up under whatever reuses the slot. Linear, but destroying is rare next to updating
+		for (TransformID child = 0; child < m_parents.size(); child++)
+		{
+			if (m_parents[child] == id)
+				SetParent(child, INVALID_TRANSFORM);
+		}
+	}
+
+	unsigned int TransformStore::Update()
+	{
+		m_changedWorlds.clear();
+		if (m_orderDirty)
+			RebuildOrder();
+
+		if (m_dirty.empty())
+			return 0;
+
+		//When everything changed the arrays are read straight through instead of through the index list
+		const TransformID* indices = nullptr;
+		if (m_dirty.size() != m_positionX.size())
+		{
+			//Ascending slots keep the scattered writes moving forward through the output arrays
+			std::sort(m_dirty.begin(), m_dirty.end());
+			indices = m_dirty.data();
+		}
+
+		//Every job writes its own slots, a range of a straight run is handled by offsetting all the arrays
+		JobSystem::ParallelFor(m_dirty.size(), TRANSFORMS_PER_JOB, [this, indices](std::size_t begin, std::size_t end)
+		{
+			if (indices)
+			{
+				Compose(m_positionX.data(), m_positionY.data(), m_positionZ.data(), m_rotationX.data(), m_rotationY.data(), m_rotationZ.data(),
+					m_rotationW.data(), m_scaleX.data(), m_scaleY.data(), m_scaleZ.data(), indices + begin, end - begin, m_worlds.data(), m_normals.data());
+			}
+			else
+			{
+				Compose(m_positionX.data() + begin, m_positionY.data() + begin, m_positionZ.data() + begin, m_rotationX.data() + begin,
+					m_rotationY.data() + begin, m_rotationZ.data() + begin, m_rotationW.data() + begin, m_scaleX.data() + begin, m_scaleY.data() + begin,
+					m_scaleZ.data() + begin, nullptr, end - begin, m_worlds.data() + begin, m_normals.data() + begin);
+			}
+		});
+
+		//A root's local matrix is its world matrix, only children keep theirs apart to combine with the parent
+		m_dirtyPositions.clear();
+		for (TransformID id : m_dirty)
+		{
+			m_dirtyFlags[id] = 0;
+			if (!m_alive[id])
+				continue;
+
+			m_dirtyPositions.push_back(m_positions[id]);
+			if (m_parents[id] != INVALID_TRANSFORM)
+			{
+				m_locals[id] = m_worlds[id];
+				m_localNormals[id] = m_normals[id];
+			}
+		}
+		m_dirty.clear();
+
+		//Everything changed, one walk over the whole order
+		if (m_dirtyPositions.size() == m_order.size())
+		{
+			for (std::uint32_t i = 0; i < m_order.size(); i++)
+				PropagateWorld(i);
+
+			return (unsigned int)m_changedWorlds.size();
+		}
+
+		//A changed slot takes its whole subtree with it. In flattened order a slot that falls inside the subtree
+		//just walked has already been updated
+		std::sort(m_dirtyPositions.begin(), m_dirtyPositions.end());
+
+		std::uint32_t end = 0;
+		for (std::uint32_t position : m_dirtyPositions)
+		{
+			if (position < end)
+				continue;
+
+			end = position + m_subtreeSizes[position];
+			for (std::uint32_t i = position; i < end; i++)
+				PropagateWorld(i);
+		}
+
+		return (unsigned int)m_changedWorlds.size();
+	}
+
+	void TransformStore::SetParent(TransformID id, TransformID parent)
+	{
+		m_parents[id] = parent;
+		m_orderDirty = true;
+
+		//The world matrix now depends on a different chain
+		MarkDirty(id);
+	}
+
+	void TransformStore::SetPosition(TransformID id, glm::vec3 position)
+	{
+		m_positionX[id] = position.x;
+		m_positionY[id] = position.y;
+		m_positionZ[id] = position.z;
+		MarkDirty(id);
+	}
+
+	void TransformStore::SetOrientation(TransformID id, glm::quat orientation)
+	{
+		m_rotationX[id] = orientation.x;
+		m_rotationY[id] = orientation.y;
+		m_rotationZ[id] = orientation.z;
+		m_rotationW[id] = orientation.w;
+		MarkDirty(id);
+	}
+
+	void TransformStore::SetScale(TransformID id, glm::vec3 scale)
+	{
+		m_scaleX[id] = scale.x;
+		m_scaleY[id] = scale.y;
+		m_scaleZ[id] = scale.z;
+		MarkDirty(id);
+	}
+
+	void TransformStore::SetRotationAngles(TransformID id, glm::vec3 angles)
+	{
+		m_angles[id] = angles;
+		SetOrientation(id, glm::angleAxis(angles.x, glm::vec3(1, 0, 0)) * glm::angleAxis(angles.y, glm::vec3(0, 1, 0)) *
+			glm::angleAxis(angles.z, glm::vec3(0, 0, 1)));
+	}
+
+	glm::vec3 TransformStore::GetPosition(TransformID id) const
+	{
+		return glm::vec3(m_positionX[id], m_positionY[id], m_positionZ[id]);
+	}
+
+	glm::quat TransformStore::GetOrientation(TransformID id) const
+	{
+		return glm::quat(m_rotationW[id], m_rotationX[id], m_rotationY[id], m_rotationZ[id]);
+	}
+
+	glm::vec3 TransformStore::GetScale(TransformID id) const
+	{
+		return glm::vec3(m_scaleX[id], m_scaleY[id], m_scaleZ[id]);
+	}
+
+	glm::vec3 TransformStore::GetRotationAngles(TransformID id) const
+	{
+		return m_angles[id];
+	}
+
+	TransformID TransformStore::GetParent(TransformID id) const
+	{
+		return m_parents[id];
+	}
+
+	const glm::mat4 & TransformStore::GetWorld(TransformID id) const
+	{
+		return m_worlds[id];
+	}
+
+	const glm::mat3 & TransformStore::GetNormal(TransformID id) const
+	{
+		return m_normals[id];
+	}
+
+	bool TransformStore::IsDirty(TransformID id) const
+	{
+		return m_dirtyFlags[id] != 0;
+	}
+
+	unsigned int TransformStore::GetCount() const
+	{
+		return (unsigned int)(m_positionX.size() - m_free.size());
+	}
+
+	const std::vector<TransformID> & TransformStore::GetChangedWorlds() const
+	{
+		return m_changedWorlds;
+	}
+
+	void TransformStore::Compose(const float* positionX, const float* positionY, const float* positionZ,
+								 const float* rotationX, const float* rotationY, const float* rotationZ, const float* rotationW,
+								 const float* scaleX, const float* scaleY, const float* scaleZ,
+								 const TransformID* indices, std::size_t count, glm::mat4* worlds, glm::mat3* normals)
+	{
+		std::size_t i = 0;
+
+#ifdef PX_TRANSFORM_SSE
+		//Four transforms per iteration, every register holds one matrix element of all four
+		const __m128 one = _mm_set1_ps(1.f), two = _mm_set1_ps(2.f), zero = _mm_setzero_ps();
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x = Gather(rotationX, indices, i), y = Gather(rotationY, indices, i);
+			__m128 z = Gather(rotationZ, indices, i), w = Gather(rotationW, indices, i);
+			__m128 sx = Gather(scaleX, indices, i), sy = Gather(scaleY, indices, i), sz = Gather(scaleZ, indices, i);
+
+			__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+			__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+			__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+			//Rotation columns
+			__m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+			__m128 r01 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+			__m128 r02 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+			__m128 r10 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+			__m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+			__m128 r12 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+			__m128 r20 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+			__m128 r21 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+			__m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+			//World is R*S, the normal matrix R*S^-1
+			ScatterColumn(_mm_mul_ps(r00, sx), _mm_mul_ps(r01, sx), _mm_mul_ps(r02, sx), zero, worlds, indices, i, 0);
+			ScatterColumn(_mm_mul_ps(r10, sy), _mm_mul_ps(r11, sy), _mm_mul_ps(r12, sy), zero, worlds, indices, i, 1);
+			ScatterColumn(_mm_mul_ps(r20, sz), _mm_mul_ps(r21, sz), _mm_mul_ps(r22, sz), zero, worlds, indices, i, 2);
+			ScatterColumn(Gather(positionX, indices, i), Gather(positionY, indices, i), Gather(positionZ, indices, i), one, worlds, indices, i, 3);
+
+			__m128 ix = _mm_div_ps(one, sx), iy = _mm_div_ps(one, sy), iz = _mm_div_ps(one, sz);
+			ScatterNormals(_mm_mul_ps(r00, ix), _mm_mul_ps(r01, ix), _mm_mul_ps(r02, ix),
+						   _mm_mul_ps(r10, iy), _mm_mul_ps(r11, iy), _mm_mul_ps(r12, iy),
+						   _mm_mul_ps(r20, iz), _mm_mul_ps(r21, iz), _mm_mul_ps(r22, iz), normals, indices, i);
+		}
+#endif
+
+		//Remainder, or everything without SSE
+		for (; i < count; i++)
+		{
+			std::size_t slot = GetSlot(indices, i);
+			ComposeOne(rotationX[slot], rotationY[slot], rotationZ[slot], rotationW[slot], glm::vec3(positionX[slot], positionY[slot], positionZ[slot]),
+				glm::vec3(scaleX[slot], scaleY[slot], scaleZ[slot]), worlds[slot], normals[slot]);
+		}
+	}
+
+	TransformStore::BenchmarkResult TransformStore::RunBenchmark(unsigned int count)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		const unsigned int RUNS = 3;
+
+		std::mt19937 random(1337);
+		std::uniform_real_distribution<float> positions(-100.f, 100.f), scales(0.5f, 2.f), axis(-1.f, 1.f);
+
+		TransformStore store;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			glm::quat orientation = glm::normalize(glm::quat(axis(random), axis(random), axis(random), axis(random)));
+			store.Create(glm::vec3(positions(random), positions(random), positions(random)), glm::vec3(scales(random), scales(random), scales(random)),
+				orientation);
+		}
+
+		//The old path, one heap object per entity and a glm compose plus 3x3 inverse each
+		struct ObjectTransform
+		{
+			glm::vec3 position;
+			glm::vec3 scale;
+			glm::quat orientation;
+			glm::mat4 world;
+			glm::mat3 normal;
+		};
+
+		std::vector<std::unique_ptr<ObjectTransform>> objects(count);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			objects[i] = std::make_unique<ObjectTransform>();
+			objects[i]->position = store.GetPosition(i);
+			objects[i]->scale = store.GetScale(i);
+			objects[i]->orientation = store.GetOrientation(i);
+		}
+
+		std::vector<glm::mat4> worlds(count);
+		std::vector<glm::mat3> normals(count);
+
+		BenchmarkResult result;
+		result.count = count;
+		result.scalarTime = result.batchTime = result.parallelTime = 1e30;
+
+		for (unsigned int run = 0; run < RUNS; run++)
+		{
+			Clock::time_point start = Clock::now();
+			for (std::unique_ptr<ObjectTransform> & object : objects)
+			{
+				object->world = glm::translate(glm::mat4(), object->position) * glm::mat4_cast(object->orientation) * glm::scale(glm::mat4(), object->scale);
+				object->normal = glm::transpose(glm::inverse(glm::mat3(object->world)));
+			}
+			result.scalarTime = std::min(result.scalarTime, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+			//The layout and SIMD on their own, without the job system
+			start = Clock::now();
+			Compose(store.m_positionX.data(), store.m_positionY.data(), store.m_positionZ.data(), store.m_rotationX.data(), store.m_rotationY.data(),
+				store.m_rotationZ.data(), store.m_rotationW.data(), store.m_scaleX.data(), store.m_scaleY.data(), store.m_scaleZ.data(),
+				nullptr, count, worlds.data(), normals.data());
+			result.batchTime = std::min(result.batchTime, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+			//Mark every slot again so each run composes all of them
+			for (unsigned int i = 0; i < count; i++)
+				store.SetScale(i, store.GetScale(i));
+
+			start = Clock::now();
+			store.Update();
+			result.parallelTime = std::min(result.parallelTime, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+
+		//Both paths have to agree, or the timings mean nothing
+		result.maxError = 0.f;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				for (unsigned int r = 0; r < 4; r++)
+				{
+					result.maxError = std::max(result.maxError, std::abs(objects[i]->world[c][r] - worlds[i][c][r]));
+					result.maxError = std::max(result.maxError, std::abs(objects[i]->world[c][r] - store.GetWorld(i)[c][r]));
+				}
+			}
+
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				for (unsigned int r = 0; r < 3; r++)
+				{
+					result.maxError = std::max(result.maxError, std::abs(objects[i]->normal[c][r] - normals[i][c][r]));
+					result.maxError = std::max(result.maxError, std::abs(objects[i]->normal[c][r] - store.GetNormal(i)[c][r]));
+				}
+			}
+		}
+
+		return result;
+	}
+
+	void TransformStore::MarkDirty(TransformID id)
+	{
+		if (m_dirtyFlags[id])
+			return;
+
+		m_dirtyFlags[id] = 1;
+		m_dirty.push_back(id);
+	}
+
+	void TransformStore::RebuildOrder()
+	{
+		//Children are bucketed by parent with a counting sort, the slots in m_children[m_childStarts[p], m_childStarts[p + 1])
+		//belong to p. A slot whose parent is gone counts as a root
+		std::size_t slots = m_parents.size();
+		std::vector<std::uint32_t> childStarts(slots + 1, 0);
+		for (TransformID slot = 0; slot < slots; slot++)
+		{
+			TransformID parent = m_parents[slot];
+			if (m_alive[slot] && parent != INVALID_TRANSFORM && m_alive[parent])
+				childStarts[parent + 1]++;
+		}
+
+		for (std::size_t slot = 0; slot < slots; slot++)
+			childStarts[slot + 1] += childStarts[slot];
+
+		std::vector<TransformID> children(childStarts[slots]);
+		std::vector<std::uint32_t> cursors(childStarts.begin(), childStarts.end() - 1);
+		for (TransformID slot = 0; slot < slots; slot++)
+		{
+			TransformID parent = m_parents[slot];
+			if (m_alive[slot] && parent != INVALID_TRANSFORM && m_alive[parent])
+				children[cursors[parent]++] = slot;
+		}
+
+		//Depth first from every root, children are pushed in reverse so they come out in slot order
+		m_order.clear();
+		m_orderParents.clear();
+		std::fill(m_positions.begin(), m_positions.end(), INVALID_TRANSFORM);
+
+		std::vector<TransformID> stack;
+		for (TransformID root = 0; root < slots; root++)
+		{
+			TransformID parent = m_parents[root];
+			if (!m_alive[root] || (parent != INVALID_TRANSFORM && m_alive[parent]))
+				continue;
+
+			stack.push_back(root);
+			while (!stack.empty())
+			{
+				TransformID slot = stack.back();
+				stack.pop_back();
+
+				m_positions[slot] = (std::uint32_t)m_order.size();
+				m_order.push_back(slot);
+				m_orderParents.push_back(slot == root ? INVALID_TRANSFORM : m_positions[m_parents[slot]]);
+
+				for (std::uint32_t child = childStarts[slot + 1]; child > childStarts[slot]; child--)
+					stack.push_back(children[child - 1]);
+			}
+		}
+
+		//Children always sit after their parent, so walking backwards finishes every subtree before its root is summed
+		m_subtreeSizes.assign(m_order.size(), 1);
+		for (std::size_t position = m_order.size(); position-- > 0;)
+		{
+			if (m_orderParents[position] != INVALID_TRANSFORM)
+				m_subtreeSizes[m_orderParents[position]] += m_subtreeSizes[position];
+		}
+
+		m_orderDirty = false;
+	}
+
+	void TransformStore::PropagateWorld(std::uint32_t position)
+	{
+		TransformID slot = m_order[position];
+		std::uint32_t parent = m_orderParents[position];
+
+		//Roots were written by Compose() already. The inverse transpose of a product is the product of the inverse
+		//transposes, so normals chain like worlds
+		if (parent != INVALID_TRANSFORM)
+		{
+			TransformID parentSlot = m_order[parent];
+			m_worlds[slot] = m_worlds[parentSlot] * m_locals[slot];
+			m_normals[slot] = m_normals[parentSlot] * m_localNormals[slot];
+		}
+
+		m_changedWorlds.push_back(slot);
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace px
+{
+	typedef std::uint32_t TransformID;
+	const TransformID INVALID_TRANSFORM = 0xffffffff;
+
+	//Local transforms of every entity in structure-of-arrays form. Setters only write the local values and queue
+	//the slot, Update() then composes the local matrices of the queued slots in one batched pass and propagates
+	//them down the hierarchy into contiguous world and normal arrays indexed by slot.
+	//The hierarchy is kept as a flattened depth-first order, parents always come before their children and every
+	//subtree is one contiguous range, so a changed slot and everything below it is a single linear walk
+	class TransformStore
+	{
+	public:
+		struct BenchmarkResult
+		{
+			unsigned int count;
+			double scalarTime;
+			double batchTime;
+			double parallelTime;
+			float maxError;
+		};
+
+	public:
+		TransformStore();
+
+	public:
+		TransformID Create(glm::vec3 position = glm::vec3(), glm::vec3 scale = glm::vec3(1.f), glm::quat orientation = glm::quat());
+
+		//Children of the slot become roots and keep their local values
+		void Destroy(TransformID id);
+
+		//Composes everything changed since the last call, returns how many world matrices were updated
+		unsigned int Update();
+
+		//The local values become relative to the parent, INVALID_TRANSFORM makes the slot a root again.
+		//The caller keeps the hierarchy free of cycles
+		void SetParent(TransformID id, TransformID parent);
+
+	public:
+		void SetPosition(TransformID id, glm::vec3 position);
+		void SetOrientation(TransformID id, glm::quat orientation);
+		void SetScale(TransformID id, glm::vec3 scale);
+
+		//The angles are kept for the editor, the orientation is built from them
+		void SetRotationAngles(TransformID id, glm::vec3 angles);
+
+	public:
+		glm::vec3 GetPosition(TransformID id) const;
+		glm::quat GetOrientation(TransformID id) const;
+		glm::vec3 GetScale(TransformID id) const;
+		glm::vec3 GetRotationAngles(TransformID id) const;
+		TransformID GetParent(TransformID id) const;
+		const glm::mat4 & GetWorld(TransformID id) const;
+		const glm::mat3 & GetNormal(TransformID id) const;
+		bool IsDirty(TransformID id) const;
+		unsigned int GetCount() const;
+
+		//Slots whose world matrix was recomputed by the last Update()
+		const std::vector<TransformID> & GetChangedWorlds() const;
+
+	public:
+		//Composes T*R*S and its inverse transpose for count transforms, four at a time with SSE when available.
+		//Slots are read from and written to indices[i], or to i when indices is null. Orientations have to be unit length
+		static void Compose(const float* positionX, const float* positionY, const float* positionZ,
+							const float* rotationX, const float* rotationY, const float* rotationZ, const float* rotationW,
+							const float* scaleX, const float* scaleY, const float* scaleZ,
+							const TransformID* indices, std::size_t count, glm::mat4* worlds, glm::mat3* normals);
+
+		//Times count random transforms through the per-object glm path, through Compose() on one thread and through
+		//Update(), which spreads Compose() over the job system. Best of a few runs
+		static BenchmarkResult RunBenchmark(unsigned int count);
+
+	private:
+		void MarkDirty(TransformID id);
+		void RebuildOrder();
+		void PropagateWorld(std::uint32_t position);
+
+	private:
+		std::vector<float> m_positionX, m_positionY, m_positionZ;
+		std::vector<float> m_rotationX, m_rotationY, m_rotationZ, m_rotationW;
+		std::vector<float> m_scaleX, m_scaleY, m_scaleZ;
+		std::vector<glm::vec3> m_angles;
+
+		std::vector<glm::mat4> m_locals, m_worlds;
+		std::vector<glm::mat3> m_localNormals, m_normals;
+
+		std::vector<std::uint8_t> m_dirtyFlags;
+		std::vector<TransformID> m_dirty;
+		std::vector<TransformID> m_free;
+		std::vector<TransformID> m_changedWorlds;
+
+		//Hierarchy, the flattened arrays are indexed by position in the depth-first order
+		std::vector<TransformID> m_parents;
+		std::vector<std::uint8_t> m_alive;
+		std::vector<std::uint32_t> m_positions;
+		std::vector<TransformID> m_order;
+		std::vector<std::uint32_t> m_orderParents;
+		std::vector<std::uint32_t> m_subtreeSizes;
+		std::vector<std::uint32_t> m_dirtyPositions;
+		bool m_orderDirty;
+	};
+}
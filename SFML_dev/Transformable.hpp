@@ -1,13 +1,13 @@
 #pragma once
-#include <memory>
-#include "Transform.hpp"
+#include "TransformStore.hpp"
 
 namespace px
 {
+	//Stored by value in the entity pool, the local values and composed matrices live in the scene's TransformStore
 	struct Transformable
 	{
-		explicit Transformable(std::unique_ptr<Transform> & transform) : transform(std::move(transform)) {}
+		explicit Transformable(TransformID id) : id(id) {}
 
-		std::unique_ptr<Transform> transform;
+		TransformID id;
 	};
 }
\ No newline at end of file
@@ -7,7 +7,10 @@
 // https://github.com/ocornut/imgui
 
 #include "imgui_impl_glfw_gl3.h"
+#include "StreamBuffer.hpp"
+#include "GpuMemory.hpp"
 #include <iostream>
+#include <string.h>
 
 // GL3W/GLFW
 #include <glad/glad.h>   // This example is using gl3w to access OpenGL functions (because it is small). You may use glew/glad/glLoadGen/etc. whatever already works for you.
@@ -28,7 +31,8 @@ static GLuint       g_FontTexture = 0;
 static int          g_ShaderHandle = 0, g_VertHandle = 0, g_FragHandle = 0;
 static int          g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0;
 static int          g_AttribLocationPosition = 0, g_AttribLocationUV = 0, g_AttribLocationColor = 0;
-static unsigned int g_VboHandle = 0, g_VaoHandle = 0, g_ElementsHandle = 0;
+static unsigned int g_VaoHandle = 0;
+static px::StreamBuffer* g_StreamBuffer = NULL;   // Vertices and indices of every draw list share one fenced ring buffer
 
 // This is the main rendering function that you have to implement and provide to ImGui (via setting up 'RenderDrawListsFn' in the ImGuiIO structure)
 // Note that this implementation is little overcomplicated because we are saving/setting up/restoring every OpenGL state explicitly, in order to be able to run within any OpenGL engine that doesn't do so. 
@@ -90,16 +94,24 @@ void ImGui_ImplGlfwGL3_RenderDrawLists(ImDrawData* draw_data)
     glBindVertexArray(g_VaoHandle);
     glBindSampler(0, 0); // Rely on combined texture/sampler state.
 
+    g_StreamBuffer->BeginFrame();
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
         const ImDrawList* cmd_list = draw_data->CmdLists[n];
-        const ImDrawIdx* idx_buffer_offset = 0;
-
-        glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
-        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert), (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsHandle);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx), (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW);
+        // Vertices and indices share one mapping, a second one could grow the ring and drop the vertices written by the first
+        size_t vtx_size = (size_t)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert);
+        size_t idx_size = (size_t)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx);
+        size_t idx_start = (vtx_size + sizeof(ImDrawIdx) - 1) / sizeof(ImDrawIdx) * sizeof(ImDrawIdx);
+        size_t vtx_offset = 0;
+        char* destination = (char*)g_StreamBuffer->Map(idx_start + idx_size, sizeof(ImDrawVert), vtx_offset);
+        memcpy(destination, cmd_list->VtxBuffer.Data, vtx_size);
+        memcpy(destination + idx_start, cmd_list->IdxBuffer.Data, idx_size);
+        g_StreamBuffer->Unmap();
+        const ImDrawIdx* idx_buffer_offset = (const ImDrawIdx*)(vtx_offset + idx_start);
+
+        // Fetch the handle after mapping, the ring may have grown into a new buffer
+        glBindVertexBuffer(0, g_StreamBuffer->GetBuffer(), (GLintptr)vtx_offset, sizeof(ImDrawVert));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_StreamBuffer->GetBuffer());
 
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
@@ -117,6 +129,7 @@ void ImGui_ImplGlfwGL3_RenderDrawLists(ImDrawData* draw_data)
             idx_buffer_offset += pcmd->ElemCount;
         }
     }
+    g_StreamBuffer->EndFrame();
 
     // Restore modified GL state
     glUseProgram(last_program);
@@ -199,6 +212,7 @@ bool ImGui_ImplGlfwGL3_CreateFontsTexture()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    px::GpuMemory::Register(px::GpuResources::Texture, g_FontTexture, px::GpuMemory::GetTextureBytes(GL_RGBA8, width, height), "ImGui font atlas");
 
     // Store our identifier
     io.Fonts->TexID = (void *)(intptr_t)g_FontTexture;
@@ -260,21 +274,23 @@ bool ImGui_ImplGlfwGL3_CreateDeviceObjects()
     g_AttribLocationUV = glGetAttribLocation(g_ShaderHandle, "UV");
     g_AttribLocationColor = glGetAttribLocation(g_ShaderHandle, "Color");
 
-    glGenBuffers(1, &g_VboHandle);
-    glGenBuffers(1, &g_ElementsHandle);
+    g_StreamBuffer = new px::StreamBuffer("ImGui geometry", 256 * 1024);
 
     glGenVertexArrays(1, &g_VaoHandle);
     glBindVertexArray(g_VaoHandle);
-    glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
     glEnableVertexAttribArray(g_AttribLocationPosition);
     glEnableVertexAttribArray(g_AttribLocationUV);
     glEnableVertexAttribArray(g_AttribLocationColor);
 
 #define OFFSETOF(TYPE, ELEMENT) ((size_t)&(((TYPE *)0)->ELEMENT))
-    glVertexAttribPointer(g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, pos));
-    glVertexAttribPointer(g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, uv));
-    glVertexAttribPointer(g_AttribLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, col));
+    glVertexAttribFormat(g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, OFFSETOF(ImDrawVert, pos));
+    glVertexAttribFormat(g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, OFFSETOF(ImDrawVert, uv));
+    glVertexAttribFormat(g_AttribLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, OFFSETOF(ImDrawVert, col));
 #undef OFFSETOF
+    // The vertex buffer and its offset are bound per draw list
+    glVertexAttribBinding(g_AttribLocationPosition, 0);
+    glVertexAttribBinding(g_AttribLocationUV, 0);
+    glVertexAttribBinding(g_AttribLocationColor, 0);
 
     ImGui_ImplGlfwGL3_CreateFontsTexture();
 
@@ -289,9 +305,9 @@ bool ImGui_ImplGlfwGL3_CreateDeviceObjects()
 void    ImGui_ImplGlfwGL3_InvalidateDeviceObjects()
 {
     if (g_VaoHandle) glDeleteVertexArrays(1, &g_VaoHandle);
-    if (g_VboHandle) glDeleteBuffers(1, &g_VboHandle);
-    if (g_ElementsHandle) glDeleteBuffers(1, &g_ElementsHandle);
-    g_VaoHandle = g_VboHandle = g_ElementsHandle = 0;
+    if (g_StreamBuffer) delete g_StreamBuffer;
+    g_VaoHandle = 0;
+    g_StreamBuffer = NULL;
 
     if (g_ShaderHandle && g_VertHandle) glDetachShader(g_ShaderHandle, g_VertHandle);
     if (g_VertHandle) glDeleteShader(g_VertHandle);
@@ -306,6 +322,7 @@ void    ImGui_ImplGlfwGL3_InvalidateDeviceObjects()
 
     if (g_FontTexture)
     {
+        px::GpuMemory::Unregister(px::GpuResources::Texture, g_FontTexture);
         glDeleteTextures(1, &g_FontTexture);
         ImGui::GetIO().Fonts->TexID = 0;
         g_FontTexture = 0;
@@ -59,4 +59,5 @@ struct AppLog
 	}
 };
 
-static AppLog gameLog;
+//Defined in Game.cpp, shared by everything that reports to the Log dock
+extern AppLog gameLog;